@@ -0,0 +1,665 @@
+#include "change_log.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include "sylar/config.h"
+#include "sylar/bytearray.h"
+#include "blog/util.h"
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <set>
+#include <type_traits>
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+static sylar::ConfigVar<uint32_t>::ptr g_change_log_flush_interval =
+    sylar::Config::Lookup("change_log.flush_interval",
+            (uint32_t)1000, "change log flush to db interval ms");
+static sylar::ConfigVar<uint32_t>::ptr g_change_log_batch_size =
+    sylar::Config::Lookup("change_log.batch_size",
+            (uint32_t)1000, "change log max records per db transaction");
+static sylar::ConfigVar<uint32_t>::ptr g_change_log_segment_size =
+    sylar::Config::Lookup("change_log.segment_size",
+            (uint32_t)(64 * 1024 * 1024), "change log segment rotate size bytes");
+
+#define USER_FIELDS(XX) \
+    XX(Id) XX(Account) XX(Email) XX(Passwd) XX(Name) XX(Code) XX(Role) \
+    XX(State) XX(IsDeleted) XX(LoginTime) XX(CreateTime) XX(UpdateTime)
+
+#define ARTICLE_FIELDS(XX) \
+    XX(Id) XX(UserId) XX(Title) XX(Type) XX(State) XX(Channel) \
+    XX(IsDeleted) XX(PublishTime) XX(Weight) XX(Views) XX(Praise) \
+    XX(Favorites) XX(CreateTime) XX(UpdateTime)
+
+#define ARTICLE_CATEGORY_REL_FIELDS(XX) \
+    XX(Id) XX(ArticleId) XX(CategoryId) XX(IsDeleted) XX(CreateTime) XX(UpdateTime)
+
+#define ARTICLE_LABEL_REL_FIELDS(XX) \
+    XX(Id) XX(ArticleId) XX(LabelId) XX(IsDeleted) XX(CreateTime) XX(UpdateTime)
+
+#define CATEGORY_FIELDS(XX) \
+    XX(Id) XX(UserId) XX(ParentId) XX(Name) XX(IsDeleted) XX(CreateTime) XX(UpdateTime)
+
+#define LABEL_FIELDS(XX) \
+    XX(Id) XX(UserId) XX(Name) XX(IsDeleted) XX(CreateTime) XX(UpdateTime)
+
+#define COMMENT_FIELDS(XX) \
+    XX(Id) XX(UserId) XX(ArticleId) XX(ParentId) XX(Content) XX(State) \
+    XX(IsDeleted) XX(CreateTime) XX(UpdateTime)
+
+static void Write(sylar::ByteArray::ptr ba, int32_t v) { ba->writeInt32(v); }
+static void Write(sylar::ByteArray::ptr ba, int64_t v) { ba->writeInt64(v); }
+static void Write(sylar::ByteArray::ptr ba, const std::string& v) { ba->writeStringVint(v); }
+static void Read(sylar::ByteArray::ptr ba, int32_t& v) { v = ba->readInt32(); }
+static void Read(sylar::ByteArray::ptr ba, int64_t& v) { v = ba->readInt64(); }
+static void Read(sylar::ByteArray::ptr ba, std::string& v) { v = ba->readStringVint(); }
+
+#define WRITE_FIELD(f) Write(ba, info->get##f());
+#define READ_FIELD(f) { \
+        std::decay<decltype(info->get##f())>::type v; \
+        Read(ba, v); \
+        info->set##f(v); \
+    }
+
+#define XX(tid, clazz, fields, apply) \
+    static std::string Encode(data::clazz::ptr info) { \
+        sylar::ByteArray::ptr ba(new sylar::ByteArray(256)); \
+        fields(WRITE_FIELD) \
+        ba->setPosition(0); \
+        return ba->toString(); \
+    } \
+    static int ApplyRow##clazz(const std::string& row, sylar::IDB::ptr db) { \
+        sylar::ByteArray::ptr ba(new sylar::ByteArray(256)); \
+        ba->write(row.c_str(), row.size()); \
+        ba->setPosition(0); \
+        data::clazz::ptr info(new data::clazz); \
+        fields(READ_FIELD) \
+        return data::clazz##Dao::apply(info, db); \
+    }
+CHANGE_LOG_TABLE_MACRO(XX);
+#undef XX
+#undef WRITE_FIELD
+#undef READ_FIELD
+
+static const uint8_t s_article_content_table = 8;
+
+static std::string EncodeContent(int64_t id, const std::string& content) {
+    sylar::ByteArray::ptr ba(new sylar::ByteArray(256));
+    ba->writeInt64(id);
+    ba->writeStringVint(content);
+    ba->setPosition(0);
+    return ba->toString();
+}
+
+static int64_t DecodeContent(const std::string& row, std::string& content) {
+    sylar::ByteArray::ptr ba(new sylar::ByteArray(256));
+    ba->write(row.c_str(), row.size());
+    ba->setPosition(0);
+    int64_t id = ba->readInt64();
+    content = ba->readStringVint();
+    return id;
+}
+
+static int ApplyArticleContent(const std::string& row, sylar::IDB::ptr db) {
+    std::string content;
+    int64_t id = DecodeContent(row, content);
+    return data::ArticleInfoDao::UpdateContent(id, content, db);
+}
+
+static int ApplyRow(uint8_t table, const std::string& row, sylar::IDB::ptr db) {
+    switch(table) {
+        case s_article_content_table:
+            return ApplyArticleContent(row, db);
+#define XX(tid, clazz, fields, apply) \
+        case tid: \
+            return ApplyRow##clazz(row, db);
+        CHANGE_LOG_TABLE_MACRO(XX);
+#undef XX
+        default:
+            SYLAR_LOG_ERROR(g_logger) << "invalid change log table=" << (uint32_t)table;
+            return 0;
+    }
+}
+
+//记录格式: [size:4][hash:4][lsn:8][table:1][row]
+static std::string Frame(uint64_t lsn, uint8_t table, const std::string& row) {
+    std::string payload;
+    payload.resize(9 + row.size());
+    memcpy(&payload[0], &lsn, 8);
+    payload[8] = (char)table;
+    memcpy(&payload[9], row.c_str(), row.size());
+
+    uint32_t size = payload.size();
+    uint32_t hash = sylar::murmur3_hash((const void*)payload.c_str(), size);
+    std::string rt;
+    rt.resize(8);
+    memcpy(&rt[0], &size, 4);
+    memcpy(&rt[4], &hash, 4);
+    rt.append(payload);
+    return rt;
+}
+
+//按序号列出path.N分段
+static void ListSegments(const std::string& path, std::vector<std::pair<uint64_t, std::string> >& segs) {
+    std::string dir = sylar::FSUtil::Dirname(path);
+    std::string prefix = sylar::FSUtil::Basename(path) + ".";
+    DIR* d = opendir(dir.c_str());
+    if(!d) {
+        return;
+    }
+    struct dirent* dp = nullptr;
+    while((dp = readdir(d)) != nullptr) {
+        std::string name = dp->d_name;
+        if(name.size() <= prefix.size() || name.size() > prefix.size() + 19
+                || name.compare(0, prefix.size(), prefix)) {
+            continue;
+        }
+        std::string num = name.substr(prefix.size());
+        if(num.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        segs.push_back(std::make_pair(std::stoull(num), dir + "/" + name));
+    }
+    closedir(d);
+    std::sort(segs.begin(), segs.end());
+}
+
+ChangeLog::ChangeLog()
+    :m_fd(-1)
+    ,m_segSeq(0)
+    ,m_offset(0)
+    ,m_lsn(0)
+    ,m_syncedLsn(0)
+    ,m_appliedLsn(0)
+    ,m_syncing(false)
+    ,m_flushing(false)
+    ,m_syncs(0)
+    ,m_records(0)
+    ,m_flushes(0)
+    ,m_fails(0)
+    ,m_skips(0) {
+}
+
+ChangeLog::~ChangeLog() {
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool ChangeLog::open(const std::string& path) {
+    std::vector<std::pair<uint64_t, std::string> > segs;
+    ListSegments(path, segs);
+    //兼容旧版本的单文件日志
+    if(!replay(path)) {
+        return false;
+    }
+    for(auto& i : segs) {
+        if(!replay(i.second)) {
+            return false;
+        }
+    }
+    sylar::FSUtil::Unlink(path);
+    for(auto& i : segs) {
+        sylar::FSUtil::Unlink(i.second);
+    }
+    sylar::Mutex::Lock lock(m_mutex);
+    m_path = path;
+    m_segSeq = segs.empty() ? 0 : segs.back().first + 1;
+    return openSegment();
+}
+
+bool ChangeLog::openSegment() {
+    std::string path = m_path + "." + std::to_string(m_segSeq);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(fd < 0) {
+        SYLAR_LOG_ERROR(g_logger) << "open change log " << path << " fail errno="
+            << errno << " errstr=" << strerror(errno);
+        return false;
+    }
+    ++m_segSeq;
+    m_fd = fd;
+    m_segPath = path;
+    m_offset = 0;
+    return true;
+}
+
+void ChangeLog::rotate(uint64_t lsn) {
+    int fd = m_fd;
+    std::string path = m_segPath;
+    if(!openSegment()) {
+        return;
+    }
+    ::close(fd);
+    m_segments.push_back({path, lsn});
+}
+
+bool ChangeLog::replay(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs) {
+        return true;
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    std::string data = ss.str();
+
+    std::vector<Record> records;
+    size_t pos = 0;
+    while(pos + 8 <= data.size()) {
+        uint32_t size = 0;
+        uint32_t hash = 0;
+        memcpy(&size, &data[pos], 4);
+        memcpy(&hash, &data[pos + 4], 4);
+        if(size < 9 || pos + 8 + size > data.size()
+                || sylar::murmur3_hash((const void*)&data[pos + 8], size) != hash) {
+            SYLAR_LOG_WARN(g_logger) << "change log " << path << " torn record at offset="
+                << pos << ", drop tail " << (data.size() - pos) << " bytes";
+            break;
+        }
+        Record r;
+        memcpy(&r.lsn, &data[pos + 8], 8);
+        r.table = data[pos + 16];
+        r.id = 0;
+        r.row = data.substr(pos + 17, size - 9);
+        records.push_back(r);
+        pos += 8 + size;
+    }
+    if(records.empty()) {
+        return true;
+    }
+
+    SYLAR_LOG_INFO(g_logger) << "change log replay " << path
+        << " records=" << records.size();
+    size_t skips = 0;
+    if(applyOrSkip(records, skips)) {
+        SYLAR_LOG_ERROR(g_logger) << "change log replay " << path << " fail";
+        return false;
+    }
+    m_skips += skips;
+    return true;
+}
+
+int ChangeLog::apply(std::vector<Record>& records, bool* row_error) {
+    auto db = GetDB();
+    if(!db) {
+        SYLAR_LOG_ERROR(g_logger) << "get db connect fail";
+        return -1;
+    }
+    auto trans = db->openTransaction();
+    if(!trans) {
+        SYLAR_LOG_ERROR(g_logger) << "open transaction fail";
+        return -1;
+    }
+    for(auto& i : records) {
+        if(ApplyRow(i.table, i.row, db)) {
+            SYLAR_LOG_ERROR(g_logger) << "apply change log lsn=" << i.lsn
+                << " table=" << (uint32_t)i.table
+                << " errno=" << db->getErrno() << " errstr=" << db->getErrStr();
+            if(row_error) {
+                *row_error = true;
+            }
+            trans->rollback();
+            return db->getErrno() ? db->getErrno() : -1;
+        }
+    }
+    if(!trans->commit()) {
+        SYLAR_LOG_ERROR(g_logger) << "commit change log fail errno="
+            << db->getErrno() << " errstr=" << db->getErrStr();
+        return db->getErrno() ? db->getErrno() : -1;
+    }
+    return 0;
+}
+
+bool ChangeLog::writeAndSync(const std::string& buf) {
+    size_t offset = 0;
+    while(offset < buf.size()) {
+        ssize_t rt = write(m_fd, buf.c_str() + offset, buf.size() - offset);
+        if(rt < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            SYLAR_LOG_ERROR(g_logger) << "write change log fail errno="
+                << errno << " errstr=" << strerror(errno);
+            return false;
+        }
+        offset += rt;
+    }
+    if(fdatasync(m_fd)) {
+        SYLAR_LOG_ERROR(g_logger) << "fdatasync change log fail errno="
+            << errno << " errstr=" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+//截掉写了一半的记录, 否则后续记录跟在残缺数据之后, 重放时会被一并丢弃
+bool ChangeLog::recover() {
+    if(ftruncate(m_fd, m_offset) || fdatasync(m_fd)) {
+        SYLAR_LOG_ERROR(g_logger) << "recover change log " << m_segPath
+            << " offset=" << m_offset << " fail errno=" << errno
+            << " errstr=" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void ChangeLog::failUnsynced(uint64_t lsn) {
+    for(auto it = m_pending.begin(); it != m_pending.end();) {
+        if(it->lsn > m_syncedLsn && it->lsn <= lsn) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for(auto& i : m_waiters) {
+        if(i.lsn <= lsn) {
+            *i.result = -1;
+        }
+    }
+}
+
+void ChangeLog::wakeup(std::list<Waiter>& waiters) {
+    for(auto& i : waiters) {
+        i.scheduler->schedule(i.fiber);
+    }
+}
+
+int ChangeLog::commit(std::vector<Record>& records) {
+    if(records.empty()) {
+        return 0;
+    }
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_fd < 0) {
+        return commitDirect(records, lock);
+    }
+    for(auto& i : records) {
+        i.lsn = ++m_lsn;
+        m_buffer.append(Frame(i.lsn, i.table, i.row));
+        m_pending.push_back(i);
+    }
+    m_records += records.size();
+    uint64_t lsn = m_lsn;
+    int rt = 0;
+
+    //组提交: 第一个到达的协程负责写盘+fdatasync, 其余协程挂起等待
+    while(m_syncedLsn < lsn) {
+        if(m_syncing) {
+            m_waiters.push_back({sylar::Scheduler::GetThis(), sylar::Fiber::GetThis(), lsn, &rt});
+            lock.unlock();
+            sylar::Fiber::YieldToHold();
+            lock.lock();
+            if(rt) {
+                return rt;
+            }
+            continue;
+        }
+        m_syncing = true;
+        std::string buf;
+        buf.swap(m_buffer);
+        uint64_t target = m_lsn;
+        lock.unlock();
+
+        bool ok = writeAndSync(buf);
+        bool usable = ok || recover();
+
+        lock.lock();
+        m_syncing = false;
+        ++m_syncs;
+        if(ok) {
+            m_offset += buf.size();
+            m_syncedLsn = target;
+            if(m_offset >= g_change_log_segment_size->getValue()) {
+                rotate(target);
+            }
+        } else {
+            //整批失败: 既不推进synced也不刷库, 调用方按失败回滚
+            ++m_fails;
+            if(!usable) {
+                SYLAR_LOG_ERROR(g_logger) << "change log " << m_segPath
+                    << " unusable, fall back to synchronous db write";
+                ::close(m_fd);
+                m_fd = -1;
+                m_segments.push_back({m_segPath, m_syncedLsn});
+                m_buffer.clear();
+                target = m_lsn;
+            }
+            failUnsynced(target);
+            rt = -1;
+        }
+        std::list<Waiter> waiters;
+        waiters.swap(m_waiters);
+        wakeup(waiters);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+//日志不可用时直接写库, 先等队列中更早的变更刷完, 避免旧快照覆盖新值
+int ChangeLog::commitDirect(std::vector<Record>& records, sylar::Mutex::Lock& lock) {
+    while(!m_pending.empty() || m_flushing) {
+        if(m_flushing) {
+            int rt = 0;
+            m_flushWaiters.push_back({sylar::Scheduler::GetThis(), sylar::Fiber::GetThis(), 0, &rt});
+            lock.unlock();
+            sylar::Fiber::YieldToHold();
+            lock.lock();
+            continue;
+        }
+        lock.unlock();
+        int rt = flushRecords();
+        lock.lock();
+        if(rt) {
+            return rt;
+        }
+    }
+    lock.unlock();
+    return apply(records);
+}
+
+int ChangeLog::applyOrSkip(std::vector<Record>& records, size_t& skips) {
+    bool row_error = false;
+    int rt = apply(records, &row_error);
+    if(!rt || !row_error) {
+        return rt;
+    }
+    for(auto& i : records) {
+        std::vector<Record> one(1, i);
+        row_error = false;
+        rt = apply(one, &row_error);
+        if(!rt) {
+            continue;
+        }
+        if(!row_error) {
+            //连接/事务失败, 整批稍后重试, 已写入的行是快照, 重复写入无影响
+            return rt;
+        }
+        ++skips;
+        SYLAR_LOG_ERROR(g_logger) << "change log skip bad record lsn=" << i.lsn
+            << " table=" << (uint32_t)i.table << " id=" << i.id
+            << " size=" << i.row.size() << " errno=" << rt;
+    }
+    return 0;
+}
+
+void ChangeLog::flush() {
+    flushRecords();
+}
+
+bool ChangeLog::getPendingContent(int64_t id, std::string& content) {
+    sylar::Mutex::Lock lock(m_mutex);
+    for(auto it = m_pending.rbegin(); it != m_pending.rend(); ++it) {
+        if(it->table == s_article_content_table && it->id == id) {
+            DecodeContent(it->row, content);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t ChangeLog::getLsn() {
+    sylar::Mutex::Lock lock(m_mutex);
+    return m_lsn;
+}
+
+uint64_t ChangeLog::getAppliedLsn() {
+    sylar::Mutex::Lock lock(m_mutex);
+    return m_appliedLsn;
+}
+
+int ChangeLog::flushRecords() {
+    std::vector<Record> records;
+    std::set<std::pair<uint8_t, int64_t> > seen;
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_flushing) {
+        return 0;
+    }
+    //只刷已落盘的记录, 同一行只需要写最新的快照
+    while(!m_pending.empty() && records.size() < g_change_log_batch_size->getValue()) {
+        auto& r = m_pending.front();
+        if(r.lsn > m_syncedLsn) {
+            break;
+        }
+        records.push_back(r);
+        m_pending.pop_front();
+    }
+    if(records.empty()) {
+        return 0;
+    }
+    m_flushing = true;
+    lock.unlock();
+
+    std::vector<Record> batch;
+    for(auto it = records.rbegin(); it != records.rend(); ++it) {
+        if(seen.insert(std::make_pair(it->table, it->id)).second) {
+            batch.push_back(*it);
+        }
+    }
+    std::reverse(batch.begin(), batch.end());
+    size_t skips = 0;
+    int rt = applyOrSkip(batch, skips);
+
+    lock.lock();
+    m_skips += skips;
+    m_flushing = false;
+    std::list<Waiter> waiters;
+    waiters.swap(m_flushWaiters);
+    wakeup(waiters);
+    if(rt) {
+        m_pending.insert(m_pending.begin(), records.begin(), records.end());
+        return rt;
+    }
+    ++m_flushes;
+    m_appliedLsn = records.back().lsn;
+    while(!m_segments.empty() && m_segments.front().lastLsn <= m_appliedLsn) {
+        sylar::FSUtil::Unlink(m_segments.front().path);
+        m_segments.pop_front();
+    }
+    if(m_pending.empty() && !m_syncing && m_buffer.empty()) {
+        truncate();
+    }
+    return 0;
+}
+
+void ChangeLog::truncate() {
+    if(m_fd < 0) {
+        return;
+    }
+    if(ftruncate(m_fd, 0)) {
+        SYLAR_LOG_ERROR(g_logger) << "truncate change log fail errno="
+            << errno << " errstr=" << strerror(errno);
+        return;
+    }
+    m_offset = 0;
+}
+
+void ChangeLog::start() {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_timer) {
+        return;
+    }
+    m_timer = sylar::IOManager::GetThis()->addTimer(g_change_log_flush_interval->getValue(),
+                [this](){ flush(); }, true);
+}
+
+void ChangeLog::stop() {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_timer) {
+        m_timer->cancel();
+        m_timer = nullptr;
+    }
+    lock.unlock();
+    while(true) {
+        lock.lock();
+        size_t size = m_pending.size();
+        lock.unlock();
+        if(!size) {
+            break;
+        }
+        flushRecords();
+        lock.lock();
+        bool progress = m_pending.size() < size;
+        lock.unlock();
+        if(!progress) {
+            break;
+        }
+    }
+}
+
+#define XX(tid, clazz, fields, apply) \
+    int ChangeLog::update(data::clazz::ptr info) { \
+        std::vector<Record> records(1); \
+        records[0].table = tid; \
+        records[0].id = info->getId(); \
+        records[0].row = Encode(info); \
+        return commit(records); \
+    } \
+    int ChangeLog::update(const std::vector<data::clazz::ptr>& infos) { \
+        std::vector<Record> records(infos.size()); \
+        for(size_t i = 0; i < infos.size(); ++i) { \
+            records[i].table = tid; \
+            records[i].id = infos[i]->getId(); \
+            records[i].row = Encode(infos[i]); \
+        } \
+        return commit(records); \
+    }
+CHANGE_LOG_TABLE_MACRO(XX);
+#undef XX
+
+int ChangeLog::update(data::ArticleInfo::ptr info, const std::string& content) {
+    std::vector<Record> records(2);
+    records[0].table = 2;
+    records[0].id = info->getId();
+    records[0].row = Encode(info);
+    records[1].table = s_article_content_table;
+    records[1].id = info->getId();
+    records[1].row = EncodeContent(info->getId(), content);
+    return commit(records);
+}
+
+std::string ChangeLog::statusString() {
+    std::stringstream ss;
+    sylar::Mutex::Lock lock(m_mutex);
+    ss << "ChangeLog path=" << m_segPath
+       << " offset=" << m_offset
+       << " segments=" << m_segments.size()
+       << " lsn=" << m_lsn
+       << " synced=" << m_syncedLsn
+       << " applied=" << m_appliedLsn
+       << " pending=" << m_pending.size()
+       << " records=" << m_records
+       << " syncs=" << m_syncs
+       << " flushes=" << m_flushes
+       << " fails=" << m_fails
+       << " skips=" << m_skips
+       << std::endl;
+    lock.unlock();
+    return ss.str();
+}
+
+}
@@ -0,0 +1,123 @@
+#ifndef __BLOG_CHANGE_LOG_H__
+#define __BLOG_CHANGE_LOG_H__
+
+#include "blog/data/article_info.h"
+#include "blog/data/article_category_rel_info.h"
+#include "blog/data/article_label_rel_info.h"
+#include "blog/data/category_info.h"
+#include "blog/data/comment_info.h"
+#include "blog/data/label_info.h"
+#include "blog/data/user_info.h"
+#include "sylar/singleton.h"
+#include "sylar/mutex.h"
+#include "sylar/iomanager.h"
+#include <list>
+#include <vector>
+
+namespace blog {
+
+//文章正文单独成一类记录(表8), 见update(info, content)
+#define CHANGE_LOG_TABLE_MACRO(XX) \
+    XX(1, UserInfo,               USER_FIELDS,                 Update) \
+    XX(2, ArticleInfo,            ARTICLE_FIELDS,              UpdateMeta) \
+    XX(3, ArticleCategoryRelInfo, ARTICLE_CATEGORY_REL_FIELDS, Update) \
+    XX(4, ArticleLabelRelInfo,    ARTICLE_LABEL_REL_FIELDS,    Update) \
+    XX(5, CategoryInfo,           CATEGORY_FIELDS,             Update) \
+    XX(6, LabelInfo,              LABEL_FIELDS,                Update) \
+    XX(7, CommentInfo,            COMMENT_FIELDS,              Update)
+
+//本地追加写的变更日志(WAL)
+//管理器先改内存, 行快照写入日志并组提交(一批一次fdatasync),
+//后台定时把日志中的变更按事务批量刷入数据库, 启动时重放未刷入的日志
+//日志按大小切分为path.N分段, 分段内记录全部刷库后删除
+//写日志失败时整批返回失败且不会刷库; 日志无法恢复时关闭, 之后同步写库
+//insert依赖数据库自增id, 仍然同步写库
+class ChangeLog {
+public:
+    ChangeLog();
+    ~ChangeLog();
+
+    bool open(const std::string& path);
+    void start();
+    void stop();
+
+#define XX(tid, clazz, fields, apply) \
+    int update(data::clazz::ptr info); \
+    int update(const std::vector<data::clazz::ptr>& infos);
+    CHANGE_LOG_TABLE_MACRO(XX);
+#undef XX
+    //文章元数据与正文同批提交, 一起成功或失败
+    int update(data::ArticleInfo::ptr info, const std::string& content);
+
+    void flush();
+    //尚未刷库的最新文章正文, 正在刷库中的记录查不到
+    bool getPendingContent(int64_t id, std::string& content);
+    //已分配的最大lsn, 调用update成功后读取, 不小于本次写入记录的lsn
+    uint64_t getLsn();
+    //lsn不大于该值的记录已刷入数据库
+    uint64_t getAppliedLsn();
+    std::string statusString();
+private:
+    struct Record {
+        uint64_t lsn;
+        uint8_t table;
+        int64_t id;
+        std::string row;
+    };
+    struct Waiter {
+        sylar::Scheduler* scheduler;
+        sylar::Fiber::ptr fiber;
+        uint64_t lsn;
+        int* result;
+    };
+    struct Segment {
+        std::string path;
+        uint64_t lastLsn;
+    };
+
+    int commit(std::vector<Record>& records);
+    int commitDirect(std::vector<Record>& records, sylar::Mutex::Lock& lock);
+    int flushRecords();
+    bool writeAndSync(const std::string& buf);
+    bool recover();
+    void failUnsynced(uint64_t lsn);
+    void wakeup(std::list<Waiter>& waiters);
+    bool replay(const std::string& path);
+    //row_error非空时, 失败由某条记录本身引起(而非连接/事务)则置true
+    int apply(std::vector<Record>& records, bool* row_error = nullptr);
+    //整批失败且是记录本身的错误时逐条重试, 始终失败的记录记日志后跳过, 不阻塞后续刷库
+    int applyOrSkip(std::vector<Record>& records, size_t& skips);
+    bool openSegment();
+    void rotate(uint64_t lsn);
+    void truncate();
+private:
+    sylar::Mutex m_mutex;
+    int m_fd;
+    std::string m_path;
+    std::string m_segPath;
+    uint64_t m_segSeq;
+    uint64_t m_offset;
+    std::list<Segment> m_segments;
+    std::string m_buffer;
+    uint64_t m_lsn;
+    uint64_t m_syncedLsn;
+    uint64_t m_appliedLsn;
+    bool m_syncing;
+    bool m_flushing;
+    std::list<Record> m_pending;
+    std::list<Waiter> m_waiters;
+    std::list<Waiter> m_flushWaiters;
+    sylar::Timer::ptr m_timer;
+
+    uint64_t m_syncs;
+    uint64_t m_records;
+    uint64_t m_flushes;
+    uint64_t m_fails;
+    uint64_t m_skips;
+};
+
+typedef sylar::Singleton<ChangeLog> ChangeLogMgr;
+
+}
+
+#endif
@@ -0,0 +1,352 @@
+#include "consistency_checker.h"
+#include "blog/util.h"
+#include "blog/change_log.h"
+#include "blog/manager/article_manager.h"
+#include "blog/manager/article_category_rel_manager.h"
+#include "blog/manager/article_label_rel_manager.h"
+#include "blog/manager/category_manager.h"
+#include "blog/manager/comment_manager.h"
+#include "blog/manager/label_manager.h"
+#include "blog/manager/user_manager.h"
+#include "sylar/config.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include "sylar/iomanager.h"
+#include <sstream>
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+static sylar::ConfigVar<bool>::ptr g_consistency_enable =
+    sylar::Config::Lookup("consistency.enable", true, "consistency checker enable");
+static sylar::ConfigVar<uint32_t>::ptr g_consistency_interval =
+    sylar::Config::Lookup("consistency.interval", (uint32_t)1000, "consistency check one chunk per interval ms");
+static sylar::ConfigVar<uint32_t>::ptr g_consistency_chunk_size =
+    sylar::Config::Lookup("consistency.chunk_size", (uint32_t)200, "consistency check id range per chunk");
+static sylar::ConfigVar<uint32_t>::ptr g_consistency_confirm_delay =
+    sylar::Config::Lookup("consistency.confirm_delay", (uint32_t)10000, "consistency mismatch recheck delay ms");
+static sylar::ConfigVar<bool>::ptr g_consistency_repair =
+    sylar::Config::Lookup("consistency.repair", false, "write confirmed mismatch rows from memory to db");
+
+static const size_t s_max_suspects = 1000;
+static const uint32_t s_max_times = 3;
+
+#define CONSISTENCY_TABLE_MACRO(XX) \
+    XX(UserInfo,               UserMgr,               "user") \
+    XX(ArticleInfo,            ArticleMgr,            "article") \
+    XX(ArticleCategoryRelInfo, ArticleCategoryRelMgr, "article_category_rel") \
+    XX(ArticleLabelRelInfo,    ArticleLabelRelMgr,    "article_label_rel") \
+    XX(CategoryInfo,           CategoryMgr,           "category") \
+    XX(LabelInfo,              LabelMgr,              "label") \
+    XX(CommentInfo,            CommentMgr,            "comment")
+
+//文章正文不常驻内存, 只比较元数据
+static std::string RowString(data::ArticleInfo::ptr info) {
+    data::ArticleInfo tmp(*info);
+    tmp.setContent("");
+    return tmp.toJsonString();
+}
+
+template<class T>
+static std::string RowString(T info) {
+    return info->toJsonString();
+}
+
+static uint64_t Digest(const std::string& str) {
+    uint64_t v = sylar::murmur3_hash64(str.c_str());
+    return v ? v : 1;
+}
+
+template<class Dao, class T>
+static int QueryRange(Dao*, std::function<void(T)> cb, int64_t begin, int64_t end, sylar::IDB::ptr db) {
+    return Dao::QueryByIdRange(cb, begin, end, db);
+}
+
+//文章只比较元数据, 不读出完整正文
+static int QueryRange(data::ArticleInfoDao*, std::function<void(data::ArticleInfo::ptr)> cb
+                      ,int64_t begin, int64_t end, sylar::IDB::ptr db) {
+    return data::ArticleInfoDao::QueryMetaByIdRange(cb, begin, end, db);
+}
+
+template<class Dao, class T, class Mgr>
+static bool Scan(int64_t begin, int64_t end, std::map<int64_t, uint64_t>& dbs
+                 ,std::map<int64_t, uint64_t>& mems) {
+    auto db = GetDB();
+    if(!db) {
+        return false;
+    }
+    std::function<void(typename T::ptr)> cb = [&dbs](typename T::ptr v) {
+        dbs[v->getId()] = Digest(RowString(v));
+    };
+    if(QueryRange((Dao*)nullptr, cb, begin, end, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "consistency scan fail errno=" << db->getErrno()
+            << " errstr=" << db->getErrStr();
+        return false;
+    }
+    //id自增且分片较小, 逐个探测区间内的内存行, 只在内存中存在的行也能发现
+    for(int64_t id = begin; id < end; ++id) {
+        auto info = Mgr::GetInstance()->get(id);
+        if(info) {
+            mems[id] = Digest(RowString(info));
+            if(!dbs.count(id)) {
+                dbs[id] = 0;
+            }
+        } else if(dbs.count(id)) {
+            mems[id] = 0;
+        }
+    }
+    return true;
+}
+
+template<class Dao, class T, class Mgr>
+static bool Check(int64_t id, uint64_t& dbv, uint64_t& memv, std::string& detail) {
+    auto db = GetDB();
+    if(!db) {
+        return false;
+    }
+    auto dinfo = Dao::Query(id, db);
+    auto minfo = Mgr::GetInstance()->get(id);
+    std::string ds = dinfo ? RowString(dinfo) : "-";
+    std::string ms = minfo ? RowString(minfo) : "-";
+    dbv = dinfo ? Digest(ds) : 0;
+    memv = minfo ? Digest(ms) : 0;
+    detail = "db=" + ds + " mem=" + ms;
+    return true;
+}
+
+//库中缺行时整行写入
+template<class Dao, class T>
+static bool UpsertRow(Dao*, T info) {
+    auto db = GetDB();
+    if(!db) {
+        return false;
+    }
+    return Dao::InsertOrUpdate(info, db) == 0;
+}
+
+//库中缺行, 正文只能取自内存(未刷库的ChangeLog记录或正文缓存), 取不到则放弃, 不能用摘要覆盖
+static bool UpsertRow(data::ArticleInfoDao*, data::ArticleInfo::ptr info) {
+    std::string content;
+    if(!ArticleMgr::GetInstance()->peekContent(info->getId(), content)) {
+        SYLAR_LOG_WARN(g_logger) << "consistency repair article id=" << info->getId()
+            << " content not in memory";
+        return false;
+    }
+    data::ArticleInfo::ptr tmp(new data::ArticleInfo(*info));
+    tmp->setContent(content);
+    auto db = GetDB();
+    if(!db) {
+        return false;
+    }
+    return data::ArticleInfoDao::InsertOrUpdate(tmp, db) == 0;
+}
+
+//ChangeLog只做update, 库中缺行时update不生效, 改为直接整行写入
+template<class Dao, class Mgr>
+static bool Repair(int64_t id, bool missing) {
+    auto info = Mgr::GetInstance()->get(id);
+    if(!info) {
+        return false;
+    }
+    if(missing) {
+        return UpsertRow((Dao*)nullptr, info);
+    }
+    return ChangeLogMgr::GetInstance()->update(info) == 0;
+}
+
+ConsistencyChecker::Table::Table()
+    :maxId(-1)
+    ,rows(0)
+    ,passes(0)
+    ,mismatchs(0)
+    ,confirms(0)
+    ,repairs(0)
+    ,unrepaired(0) {
+}
+
+ConsistencyChecker::ConsistencyChecker()
+    :m_table(0)
+    ,m_cursor(0)
+    ,m_running(false) {
+#define XX(clazz, mgr, tname) \
+    m_tables.emplace_back(); \
+    m_tables.back().name = tname; \
+    m_tables.back().scan = Scan<data::clazz##Dao, data::clazz, mgr>; \
+    m_tables.back().check = Check<data::clazz##Dao, data::clazz, mgr>; \
+    m_tables.back().repair = Repair<data::clazz##Dao, mgr>;
+    CONSISTENCY_TABLE_MACRO(XX);
+#undef XX
+}
+
+void ConsistencyChecker::addSuspect(size_t table, int64_t id, uint64_t db, uint64_t mem, uint32_t times) {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_suspects.size() >= s_max_suspects) {
+        return;
+    }
+    Suspect s;
+    s.table = table;
+    s.id = id;
+    s.db = db;
+    s.mem = mem;
+    s.checkTime = sylar::GetCurrentMS() + g_consistency_confirm_delay->getValue();
+    s.times = times;
+    m_suspects.push_back(s);
+}
+
+bool ConsistencyChecker::scanChunk() {
+    auto& table = m_tables[m_table];
+    if(table.maxId < 0) {
+        auto db = GetDB();
+        auto res = db ? db->query("select max(id) from " + table.name) : nullptr;
+        if(!res) {
+            return false;
+        }
+        table.maxId = (res->next() && !res->isNull(0)) ? res->getInt64(0) : 0;
+    }
+
+    int64_t begin = m_cursor;
+    int64_t end = begin + g_consistency_chunk_size->getValue();
+    Digests dbs;
+    Digests mems;
+    if(!table.scan(begin, end, dbs, mems)) {
+        return false;
+    }
+
+    //区间校验和一致则整段跳过, 否则逐行找出差异
+    uint64_t dsum = 0;
+    uint64_t msum = 0;
+    for(auto& i : dbs) {
+        dsum += i.second * (uint64_t)(i.first * 2 + 1);
+    }
+    for(auto& i : mems) {
+        msum += i.second * (uint64_t)(i.first * 2 + 1);
+    }
+    size_t mismatchs = 0;
+    if(dsum != msum) {
+        for(auto& i : dbs) {
+            uint64_t mem = mems[i.first];
+            if(mem != i.second) {
+                addSuspect(m_table, i.first, i.second, mem, 0);
+                ++mismatchs;
+            }
+        }
+    }
+
+    sylar::Mutex::Lock lock(m_mutex);
+    table.rows += dbs.size();
+    table.mismatchs += mismatchs;
+    //库中最大id之后再多查一个分片, 覆盖只在内存中存在的新行
+    if(begin > table.maxId) {
+        ++table.passes;
+        table.maxId = -1;
+        m_cursor = 0;
+        m_table = (m_table + 1) % m_tables.size();
+    } else {
+        m_cursor = end;
+    }
+    return true;
+}
+
+void ConsistencyChecker::checkSuspects(uint64_t now) {
+    size_t limit = g_consistency_chunk_size->getValue();
+    std::list<Suspect> dues;
+    sylar::Mutex::Lock lock(m_mutex);
+    for(auto it = m_suspects.begin();
+            it != m_suspects.end() && dues.size() < limit;) {
+        if(it->checkTime <= now) {
+            dues.push_back(*it);
+            it = m_suspects.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    lock.unlock();
+
+    bool repair = g_consistency_repair->getValue();
+    for(auto& s : dues) {
+        auto& table = m_tables[s.table];
+        uint64_t db = 0;
+        uint64_t mem = 0;
+        std::string detail;
+        if(!table.check(s.id, db, mem, detail)) {
+            addSuspect(s.table, s.id, s.db, s.mem, s.times);
+            continue;
+        }
+        if(db == mem) {
+            continue;
+        }
+        //两侧都没变化仍不一致才确认, 还在变化的行稍后再查
+        if(db != s.db || mem != s.mem) {
+            if(s.times + 1 < s_max_times) {
+                addSuspect(s.table, s.id, db, mem, s.times + 1);
+            }
+            continue;
+        }
+        SYLAR_LOG_WARN(g_logger) << "consistency mismatch table=" << table.name
+            << " id=" << s.id << " " << detail;
+        bool repaired = repair && mem && table.repair(s.id, db == 0);
+        lock.lock();
+        ++table.confirms;
+        if(repaired) {
+            ++table.repairs;
+        } else if(repair) {
+            ++table.unrepaired;
+        }
+        lock.unlock();
+    }
+}
+
+void ConsistencyChecker::onTimer() {
+    {
+        sylar::Mutex::Lock lock(m_mutex);
+        if(m_running || !g_consistency_enable->getValue()) {
+            return;
+        }
+        m_running = true;
+    }
+    checkSuspects(sylar::GetCurrentMS());
+    scanChunk();
+    sylar::Mutex::Lock lock(m_mutex);
+    m_running = false;
+}
+
+void ConsistencyChecker::start() {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_timer) {
+        return;
+    }
+    m_timer = sylar::IOManager::GetThis()->addTimer(g_consistency_interval->getValue(),
+                std::bind(&ConsistencyChecker::onTimer, this), true);
+}
+
+void ConsistencyChecker::stop() {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(!m_timer) {
+        return;
+    }
+    m_timer->cancel();
+    m_timer = nullptr;
+}
+
+std::string ConsistencyChecker::statusString() {
+    std::stringstream ss;
+    sylar::Mutex::Lock lock(m_mutex);
+    ss << "ConsistencyChecker table=" << m_tables[m_table].name
+       << " cursor=" << m_cursor
+       << " suspects=" << m_suspects.size()
+       << std::endl;
+    for(auto& i : m_tables) {
+        ss << "    " << i.name
+           << " rows=" << i.rows
+           << " passes=" << i.passes
+           << " mismatchs=" << i.mismatchs
+           << " confirms=" << i.confirms
+           << " repairs=" << i.repairs
+           << " unrepaired=" << i.unrepaired
+           << std::endl;
+    }
+    return ss.str();
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef __BLOG_CONSISTENCY_CHECKER_H__
+#define __BLOG_CONSISTENCY_CHECKER_H__
+
+#include "sylar/singleton.h"
+#include "sylar/mutex.h"
+#include "sylar/timer.h"
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace blog {
+
+//后台校验管理器内存与数据库是否一致
+//按id区间分片轮转各表, 比较两侧的区间校验和, 不一致时逐行比对
+//行差异需间隔一段时间复查仍不变才确认, 排除ChangeLog尚未刷库的正常延迟
+//每次定时器只处理一个分片, 控制对数据库的压力
+class ConsistencyChecker {
+public:
+    ConsistencyChecker();
+
+    void start();
+    void stop();
+
+    std::string statusString();
+private:
+    //行摘要, 0表示该侧不存在
+    typedef std::map<int64_t, uint64_t> Digests;
+
+    struct Table {
+        Table();
+        std::string name;
+        std::function<bool(int64_t, int64_t, Digests&, Digests&)> scan;
+        std::function<bool(int64_t, uint64_t&, uint64_t&, std::string&)> check;
+        //第二个参数表示库中缺行
+        std::function<bool(int64_t, bool)> repair;
+        int64_t maxId;
+        uint64_t rows;
+        uint64_t passes;
+        uint64_t mismatchs;
+        uint64_t confirms;
+        uint64_t repairs;
+        //开启修复但修不了的行: 内存中已没有, 或缺行的文章正文不在内存中
+        uint64_t unrepaired;
+    };
+
+    struct Suspect {
+        size_t table;
+        int64_t id;
+        uint64_t db;
+        uint64_t mem;
+        uint64_t checkTime;
+        uint32_t times;
+    };
+
+    void onTimer();
+    bool scanChunk();
+    void checkSuspects(uint64_t now);
+    void addSuspect(size_t table, int64_t id, uint64_t db, uint64_t mem, uint32_t times);
+private:
+    sylar::Mutex m_mutex;
+    std::vector<Table> m_tables;
+    size_t m_table;
+    int64_t m_cursor;
+    std::list<Suspect> m_suspects;
+    bool m_running;
+    sylar::Timer::ptr m_timer;
+};
+
+typedef sylar::Singleton<ConsistencyChecker> ConsistencyCheckerMgr;
+
+}
+
+#endif
@@ -12,47 +12,149 @@
 #include "sylar/db/mysql.h"
 
 #include "sylar/log.h"
+#include "sylar/thread.h"
+#include "sylar/mutex.h"
+#include "sylar/util.h"
+
+#include <atomic>
+#include <fstream>
+#include <list>
+#include <set>
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
+//按主键区间[begin, end)读取一个分片, 在目标库一个事务内批量写入
 template<class Dao, class T>
-bool trans_data(sylar::IDB::ptr from, sylar::IDB::ptr to) {
+int trans_range(int64_t begin, int64_t end, sylar::IDB::ptr from
+                ,sylar::IDB::ptr to, size_t& rows) {
     std::vector<typename T::ptr> vals;
-    if(Dao::QueryAll(vals, from)) {
-        SYLAR_LOG_ERROR(g_logger) << "query_all fail type:"
+    rows = 0;
+    if(Dao::QueryByIdRange([&vals](typename T::ptr v) {
+                vals.push_back(v);
+            }, begin, end, from)) {
+        SYLAR_LOG_ERROR(g_logger) << "query range fail type:"
             << sylar::TypeToName<Dao>() << " " << from->getErrStr()
-            << " (" << from->getErrno() << ")";
-        return false;
+            << " (" << from->getErrno() << ") range=[" << begin << ", " << end << ")";
+        return -1;
+    }
+    if(vals.empty()) {
+        return 0;
     }
 
     auto trans = to->openTransaction();
     if(!trans) {
         SYLAR_LOG_ERROR(g_logger) << "openTransaction fail type:"
-            << sylar::TypeToName<Dao>() << " " << from->getErrStr()
-            << " (" << from->getErrno() << ")";
-        return false;
+            << sylar::TypeToName<Dao>() << " " << to->getErrStr()
+            << " (" << to->getErrno() << ")";
+        return -1;
     }
-    bool has_error = false;
-    for(auto& i : vals) {
-        if(Dao::InsertOrUpdate(i, to)) {
-            SYLAR_LOG_ERROR(g_logger) << "InsertOrUpdate fail type:"
-                << sylar::TypeToName<Dao>() << " " << from->getErrStr()
-                << " (" << from->getErrno() << ") data=" << i->toJsonString();
-            has_error = true;
-            break;
-        }
+    if(Dao::UpsertMany(vals, to)) {
+        SYLAR_LOG_ERROR(g_logger) << "UpsertMany fail type:"
+            << sylar::TypeToName<Dao>() << " " << to->getErrStr()
+            << " (" << to->getErrno() << ") range=[" << begin << ", " << end << ")";
+        trans->rollback();
+        return -1;
+    }
+    if(!trans->commit()) {
+        SYLAR_LOG_ERROR(g_logger) << "commit fail type:"
+            << sylar::TypeToName<Dao>() << " " << to->getErrStr()
+            << " (" << to->getErrno() << ")";
+        return -1;
     }
+    rows = vals.size();
+    return 0;
+}
+
+struct Table {
+    std::string name;
+    std::function<int(int64_t, int64_t, sylar::IDB::ptr, sylar::IDB::ptr, size_t&)> trans;
+    std::function<int(sylar::IDB::ptr)> createSQLite3;
+    std::function<int(sylar::IDB::ptr)> createMySQL;
+    std::atomic<uint64_t> rows;
+    std::atomic<uint64_t> chunks;
+    std::atomic<uint64_t> fails;
+};
 
-    if(!has_error) {
-        if(!trans->commit()) {
-            SYLAR_LOG_ERROR(g_logger) << "commit fail type:"
-                << sylar::TypeToName<Dao>() << " " << from->getErrStr()
-                << " (" << from->getErrno() << ")";
-            return false;
+struct Task {
+    Table* table;
+    int64_t begin;
+    int64_t end;
+};
+
+//首行记录"# from to chunk_size", 参数不一致时拒绝续传
+//已完成的分片每行记录"table begin end rows", 重新执行时跳过
+class Checkpoint {
+public:
+    bool open(const std::string& path, const std::string& header) {
+        std::ifstream ifs(path);
+        std::string line;
+        bool empty = true;
+        if(std::getline(ifs, line)) {
+            empty = false;
+            if(line != header) {
+                std::cout << "checkpoint " << path << " was created with other args" << std::endl;
+                std::cout << "  checkpoint: " << line << std::endl;
+                std::cout << "  current:    " << header << std::endl;
+                std::cout << "  remove it or use another checkpoint file" << std::endl;
+                return false;
+            }
         }
-        return true;
+        while(std::getline(ifs, line)) {
+            auto parts = sylar::split(line, ' ');
+            if(parts.size() < 3) {
+                continue;
+            }
+            m_dones.insert(parts[0] + " " + parts[1] + " " + parts[2]);
+        }
+        m_ofs.open(path, std::ios::app);
+        if(m_ofs && empty) {
+            m_ofs << header << std::endl;
+        }
+        return (bool)m_ofs;
     }
-    return false;
+
+    bool isDone(const Task& t) {
+        return m_dones.count(key(t));
+    }
+
+    void done(const Task& t, size_t rows) {
+        sylar::Mutex::Lock lock(m_mutex);
+        m_ofs << key(t) << " " << rows << std::endl;
+    }
+
+    size_t size() const { return m_dones.size(); }
+private:
+    static std::string key(const Task& t) {
+        return t.table->name + " " + std::to_string(t.begin) + " " + std::to_string(t.end);
+    }
+private:
+    sylar::Mutex m_mutex;
+    std::set<std::string> m_dones;
+    std::ofstream m_ofs;
+};
+
+static int64_t GetMaxId(sylar::IDB::ptr db, const std::string& table) {
+    auto res = db->query("select max(id) from " + table);
+    if(!res) {
+        SYLAR_LOG_ERROR(g_logger) << "query max id fail table=" << table
+            << " " << db->getErrStr() << " (" << db->getErrno() << ")";
+        return -1;
+    }
+    if(!res->next() || res->isNull(0)) {
+        return 0;
+    }
+    return res->getInt64(0);
+}
+
+//mysql连接串中的密码不写入checkpoint
+static std::string MaskUri(const std::string& uri) {
+    auto pos = uri.find("passwd=");
+    if(pos == std::string::npos) {
+        return uri;
+    }
+    pos += 7;
+    auto end = uri.find('&', pos);
+    return uri.substr(0, pos) + "***" + (end == std::string::npos ? "" : uri.substr(end));
 }
 
 struct ConnInfo {
@@ -100,12 +202,14 @@ sylar::IDB::ptr createConn(const ConnInfo& info) {
 
 int main(int argc, char** argv) {
     if(argc < 3) {
-        std::cout << "Use as[" << argv[0] << " uri uri2" << std::endl;
+        std::cout << "Use as[" << argv[0] << " uri uri2 [threads] [chunk_size] [checkpoint]" << std::endl;
         std::cout << "  uri,uri2: 连接地址,sqlite3$/path/to/db" << std::endl;
         std::cout << "   mysql为mysql$host=xxx&user=xxx&passwd=xx&dbname=xxx" << std::endl;
+        std::cout << "  threads: 并发数, 默认4" << std::endl;
+        std::cout << "  chunk_size: 每个分片的主键跨度, 默认10000" << std::endl;
+        std::cout << "  checkpoint: 进度文件, 默认data_dump.checkpoint, 中断后重新执行即可续传" << std::endl;
         return 0;
     }
-    sylar::IDB::ptr from, to;
     ConnInfo from_info, to_info;
     if(!ParserString(argv[1], from_info)) {
         std::cout << "invalid uri: " << argv[1] << std::endl;
@@ -115,33 +219,142 @@ int main(int argc, char** argv) {
         std::cout << "invalid uri: " << argv[2] << std::endl;
         return 0;
     }
+    int threads = argc > 3 ? sylar::TypeUtil::Atoi(argv[3]) : 4;
+    int64_t chunk_size = argc > 4 ? sylar::TypeUtil::Atoi(argv[4]) : 10000;
+    std::string checkpoint_path = argc > 5 ? argv[5] : "data_dump.checkpoint";
+    if(threads <= 0) {
+        threads = 1;
+    }
+    if(chunk_size <= 0) {
+        chunk_size = 10000;
+    }
+    //sqlite3同一时间只允许一个写者
+    if(to_info.type == "sqlite3" && threads > 1) {
+        SYLAR_LOG_INFO(g_logger) << "target is sqlite3, threads " << threads << " => 1";
+        threads = 1;
+    }
 
-    from = createConn(from_info);
-    to = createConn(to_info);
+    auto from = createConn(from_info);
+    auto to = createConn(to_info);
     if(!from || !to) {
         return 0;
     }
-#define XX(type) \
-    if(std::dynamic_pointer_cast<sylar::SQLite3>(to)) { \
-        if(!type ## Dao::CreateTableSQLite3(to)) { \
-            SYLAR_LOG_ERROR(g_logger) << to->getErrStr() << "(" << to->getErrno() << ")"; \
-        } \
-    } else {\
-        if(!type ## Dao::CreateTableMySQL(to)) { \
-            SYLAR_LOG_ERROR(g_logger) << to->getErrStr() << "(" << to->getErrno() << ")"; \
-        } \
-    } \
-    if(!trans_data<type ## Dao, type>(from, to)) { \
-        SYLAR_LOG_ERROR(g_logger) << "trans_data fail " #type; \
-    }
-    XX(blog::data::ArticleInfo);
-    XX(blog::data::ArticleCategoryRelInfo);
-    XX(blog::data::ArticleLabelRelInfo);
-    XX(blog::data::CategoryInfo);
-    XX(blog::data::CommentInfo);
-    XX(blog::data::LabelInfo);
-    XX(blog::data::UserInfo);
-    XX(blog::data::ChannelInfo);
+
+    Checkpoint checkpoint;
+    std::string header = "# " + MaskUri(argv[1]) + " " + MaskUri(argv[2])
+        + " " + std::to_string(chunk_size);
+    if(!checkpoint.open(checkpoint_path, header)) {
+        std::cout << "open checkpoint fail: " << checkpoint_path << std::endl;
+        return 0;
+    }
+
+    std::list<Table> tables;
+#define XX(type, tname) \
+    tables.emplace_back(); \
+    tables.back().name = tname; \
+    tables.back().trans = trans_range<type ## Dao, type>; \
+    tables.back().createSQLite3 = type ## Dao::CreateTableSQLite3; \
+    tables.back().createMySQL = type ## Dao::CreateTableMySQL;
+    XX(blog::data::ArticleInfo, "article");
+    XX(blog::data::ArticleCategoryRelInfo, "article_category_rel");
+    XX(blog::data::ArticleLabelRelInfo, "article_label_rel");
+    XX(blog::data::CategoryInfo, "category");
+    XX(blog::data::CommentInfo, "comment");
+    XX(blog::data::LabelInfo, "label");
+    XX(blog::data::UserInfo, "user");
+    XX(blog::data::ChannelInfo, "channel");
 #undef XX
+
+    std::vector<Task> tasks;
+    for(auto& t : tables) {
+        t.rows = t.chunks = t.fails = 0;
+        //续传时表已存在, 建表失败不影响
+        int rt = std::dynamic_pointer_cast<sylar::SQLite3>(to)
+            ? t.createSQLite3(to) : t.createMySQL(to);
+        if(rt) {
+            SYLAR_LOG_INFO(g_logger) << "create table " << t.name << " fail: "
+                << to->getErrStr() << "(" << to->getErrno() << ")";
+        }
+        int64_t max_id = GetMaxId(from, t.name);
+        if(max_id < 0) {
+            return 0;
+        }
+        for(int64_t begin = 0; begin <= max_id; begin += chunk_size) {
+            Task task{&t, begin, begin + chunk_size};
+            if(!checkpoint.isDone(task)) {
+                tasks.push_back(task);
+            }
+        }
+        SYLAR_LOG_INFO(g_logger) << "table " << t.name << " max_id=" << max_id;
+    }
+    from.reset();
+    to.reset();
+    SYLAR_LOG_INFO(g_logger) << "data_dump tasks=" << tasks.size()
+        << " skip=" << checkpoint.size() << " threads=" << threads
+        << " chunk_size=" << chunk_size;
+
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> total_rows(0);
+    std::atomic<uint64_t> last_report(0);
+    uint64_t start = sylar::GetCurrentMS();
+    auto report = [&](bool force) {
+        uint64_t now = sylar::GetCurrentMS();
+        uint64_t last = last_report;
+        if(!force && (now < last + 5000
+                    || !last_report.compare_exchange_strong(last, now))) {
+            return;
+        }
+        uint64_t used = std::max(now - start, (uint64_t)1);
+        SYLAR_LOG_INFO(g_logger) << "data_dump progress chunks="
+            << std::min((size_t)next, tasks.size()) << "/" << tasks.size()
+            << " rows=" << total_rows << " used=" << used << "ms"
+            << " rows/s=" << (total_rows * 1000 / used);
+    };
+
+    //每个线程独立的源/目标连接, 从共享的任务表中领取分片
+    std::vector<sylar::Thread::ptr> thrs;
+    for(int i = 0; i < threads; ++i) {
+        thrs.push_back(std::make_shared<sylar::Thread>([&]() {
+            auto from = createConn(from_info);
+            auto to = createConn(to_info);
+            if(!from || !to) {
+                SYLAR_LOG_ERROR(g_logger) << "data_dump worker connect fail";
+                return;
+            }
+            while(true) {
+                size_t idx = next++;
+                if(idx >= tasks.size()) {
+                    break;
+                }
+                auto& task = tasks[idx];
+                size_t rows = 0;
+                if(task.table->trans(task.begin, task.end, from, to, rows)) {
+                    ++task.table->fails;
+                    continue;
+                }
+                checkpoint.done(task, rows);
+                task.table->rows += rows;
+                ++task.table->chunks;
+                total_rows += rows;
+                report(false);
+            }
+        }, "data_dump_" + std::to_string(i)));
+    }
+    for(auto& i : thrs) {
+        i->join();
+    }
+
+    report(true);
+    uint64_t fails = 0;
+    for(auto& t : tables) {
+        fails += t.fails;
+        SYLAR_LOG_INFO(g_logger) << "table " << t.name << " rows=" << t.rows
+            << " chunks=" << t.chunks << " fails=" << t.fails;
+    }
+    if(fails) {
+        SYLAR_LOG_ERROR(g_logger) << "data_dump " << fails
+            << " chunks fail, run again with the same checkpoint to resume";
+        return 1;
+    }
     return 0;
 }
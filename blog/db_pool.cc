@@ -0,0 +1,380 @@
+#include "db_pool.h"
+#include "blog/util.h"
+#include "sylar/config.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include "sylar/db/sqlite3.h"
+#include "sylar/iomanager.h"
+#include <algorithm>
+#include <cstdarg>
+#include <sstream>
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+static sylar::ConfigVar<uint32_t>::ptr g_db_pool_max_size =
+    sylar::Config::Lookup("db.pool.max_size", (uint32_t)16, "db pool max connections");
+
+static sylar::ConfigVar<uint32_t>::ptr g_db_pool_check_interval =
+    sylar::Config::Lookup("db.pool.check_interval", (uint32_t)30000, "db pool idle connection check interval ms");
+
+static sylar::ConfigVar<uint32_t>::ptr g_db_pool_max_stmts =
+    sylar::Config::Lookup("db.pool.max_stmts", (uint32_t)128, "db pool max cached stmts per connection");
+
+static sylar::ConfigVar<std::string>::ptr g_db_replica_name =
+    sylar::Config::Lookup("db.replica.name", std::string(""), "read replica db name, empty disable");
+
+static sylar::ConfigVar<uint32_t>::ptr g_db_replica_max_lag =
+    sylar::Config::Lookup("db.replica.max_lag", (uint32_t)5000, "read replica max lag ms");
+
+static sylar::ConfigVar<uint32_t>::ptr g_db_replica_heartbeat_interval =
+    sylar::Config::Lookup("db.replica.heartbeat_interval", (uint32_t)1000, "primary heartbeat write interval ms");
+
+//借出期间独占Conn, 析构时归还连接池
+class DBPool::PooledDB : public sylar::IDB {
+public:
+    PooledDB(DBPool* pool, Conn* conn)
+        :m_pool(pool)
+        ,m_conn(conn) {
+    }
+
+    ~PooledDB() {
+        m_pool->release(m_conn);
+    }
+
+    int execute(const char* format, ...) override {
+        va_list ap;
+        va_start(ap, format);
+        std::string sql = sylar::StringUtil::Formatv(format, ap);
+        va_end(ap);
+        return m_conn->db->execute(sql);
+    }
+
+    int execute(const std::string& sql) override {
+        return m_conn->db->execute(sql);
+    }
+
+    int64_t getLastInsertId() override {
+        return m_conn->db->getLastInsertId();
+    }
+
+    sylar::ISQLData::ptr query(const char* format, ...) override {
+        va_list ap;
+        va_start(ap, format);
+        std::string sql = sylar::StringUtil::Formatv(format, ap);
+        va_end(ap);
+        return m_conn->db->query(sql);
+    }
+
+    sylar::ISQLData::ptr query(const std::string& sql) override {
+        return m_conn->db->query(sql);
+    }
+
+    sylar::IStmt::ptr prepare(const std::string& sql) override {
+        return m_pool->prepare(m_conn, sql);
+    }
+
+    int getErrno() override {
+        return m_conn->db->getErrno();
+    }
+
+    std::string getErrStr() override {
+        return m_conn->db->getErrStr();
+    }
+
+    sylar::ITransaction::ptr openTransaction(bool auto_commit) override {
+        return m_conn->db->openTransaction(auto_commit);
+    }
+private:
+    DBPool* m_pool;
+    Conn* m_conn;
+};
+
+DBPool::Conn::Conn()
+    :lastUsed(0)
+    ,tid(0)
+    ,suspect(false) {
+}
+
+DBPool::DBPool(const std::string& name)
+    :m_name(name)
+    ,m_total(0)
+    ,m_gets(0)
+    ,m_inUse(0)
+    ,m_created(0)
+    ,m_exhausted(0)
+    ,m_checkFails(0)
+    ,m_acquireUs(0)
+    ,m_maxAcquireUs(0)
+    ,m_stmtHits(0)
+    ,m_stmtMisses(0) {
+}
+
+sylar::IDB::ptr DBPool::create() {
+    ++m_created;
+    return GetRawDB(m_name);
+}
+
+bool DBPool::check(Conn* conn, uint64_t now) {
+    if(!conn->suspect && conn->lastUsed + g_db_pool_check_interval->getValue() > now) {
+        return true;
+    }
+    auto res = conn->db->query("select 1");
+    if(res) {
+        conn->suspect = false;
+        return true;
+    }
+    ++m_checkFails;
+    SYLAR_LOG_WARN(g_logger) << "db pool check fail errno=" << conn->db->getErrno()
+        << " errstr=" << conn->db->getErrStr();
+    return false;
+}
+
+sylar::IDB::ptr DBPool::get() {
+    uint64_t ts = sylar::GetCurrentUS();
+    ++m_gets;
+    pid_t tid = sylar::GetThreadId();
+    Conn* conn = nullptr;
+    while(!conn) {
+        sylar::Mutex::Lock lock(m_mutex);
+        if(m_idle.empty()) {
+            if(m_total >= g_db_pool_max_size->getValue()) {
+                break;
+            }
+            ++m_total;
+            lock.unlock();
+            conn = new Conn;
+            conn->db = create();
+            if(!conn->db) {
+                delete conn;
+                conn = nullptr;
+                lock.lock();
+                --m_total;
+                return nullptr;
+            }
+            break;
+        }
+        auto it = m_idle.begin();
+        for(auto iit = m_idle.begin(); iit != m_idle.end(); ++iit) {
+            if((*iit)->tid == tid) {
+                it = iit;
+                break;
+            }
+        }
+        conn = *it;
+        m_idle.erase(it);
+        lock.unlock();
+
+        if(!check(conn, ts / 1000)) {
+            delete conn;
+            conn = nullptr;
+            lock.lock();
+            --m_total;
+        }
+    }
+
+    //池满时不等待, 这里统计的是取连接(含新建和健康检查)的耗时
+    uint64_t used = sylar::GetCurrentUS() - ts;
+    m_acquireUs += used;
+    uint64_t max_acquire = m_maxAcquireUs;
+    while(used > max_acquire && !m_maxAcquireUs.compare_exchange_weak(max_acquire, used));
+
+    if(!conn) {
+        //连接池已满, 退化为不缓存语句的临时连接
+        ++m_exhausted;
+        return GetRawDB(m_name);
+    }
+    ++m_inUse;
+    return std::make_shared<PooledDB>(this, conn);
+}
+
+void DBPool::release(Conn* conn) {
+    //单行查询只取一次next, 语句不reset会一直持有SHARED锁(WAL下为旧快照)
+    for(auto& i : conn->used) {
+        std::static_pointer_cast<sylar::SQLite3Stmt>(i)->reset();
+    }
+    conn->used.clear();
+    --m_inUse;
+    conn->lastUsed = sylar::GetCurrentMS();
+    conn->tid = sylar::GetThreadId();
+    sylar::Mutex::Lock lock(m_mutex);
+    m_idle.push_front(conn);
+}
+
+sylar::IStmt::ptr DBPool::prepare(Conn* conn, const std::string& sql) {
+    auto it = conn->stmts.find(sql);
+    if(it != conn->stmts.end()) {
+        ++m_stmtHits;
+        //sqlite的语句执行后需reset才能重新绑定执行
+        auto stmt = std::dynamic_pointer_cast<sylar::SQLite3Stmt>(it->second);
+        if(stmt) {
+            stmt->reset();
+            markUsed(conn, stmt);
+        }
+        return it->second;
+    }
+    ++m_stmtMisses;
+    auto stmt = conn->db->prepare(sql);
+    if(!stmt) {
+        //下次借出时先做检查
+        conn->suspect = true;
+        return nullptr;
+    }
+    if(conn->stmts.size() >= g_db_pool_max_stmts->getValue()) {
+        conn->stmts.clear();
+    }
+    conn->stmts[sql] = stmt;
+    if(std::dynamic_pointer_cast<sylar::SQLite3Stmt>(stmt)) {
+        markUsed(conn, stmt);
+    }
+    return stmt;
+}
+
+void DBPool::markUsed(Conn* conn, sylar::IStmt::ptr stmt) {
+    //同一借出期间循环执行同一语句时不重复记录
+    if(std::find(conn->used.begin(), conn->used.end(), stmt) == conn->used.end()) {
+        conn->used.push_back(stmt);
+    }
+}
+
+std::string DBPool::statusString() {
+    size_t idle = 0;
+    uint32_t total = 0;
+    {
+        sylar::Mutex::Lock lock(m_mutex);
+        idle = m_idle.size();
+        total = m_total;
+    }
+    std::stringstream ss;
+    ss << "DBPool name=" << m_name
+       << " total=" << total
+       << " idle=" << idle
+       << " in_use=" << m_inUse
+       << " gets=" << m_gets
+       << " created=" << m_created
+       << " exhausted=" << m_exhausted
+       << " check_fails=" << m_checkFails
+       << " acquire_us=" << m_acquireUs
+       << " max_acquire_us=" << m_maxAcquireUs
+       << " stmt_hits=" << m_stmtHits
+       << " stmt_misses=" << m_stmtMisses
+       << std::endl;
+    return ss.str();
+}
+
+static int64_t ReadHeartbeat(DBPool::ptr pool) {
+    auto db = pool->get();
+    if(!db) {
+        return -1;
+    }
+    auto res = db->query("select ts from db_heartbeat where id = 1");
+    if(!res) {
+        return -1;
+    }
+    return res->next() ? res->getInt64(0) : 0;
+}
+
+DBRouter::DBRouter()
+    :m_primary(std::make_shared<DBPool>("blog"))
+    ,m_lag(-1)
+    ,m_lagTime(0)
+    ,m_reads(0)
+    ,m_replicaReads(0)
+    ,m_fallbacks(0) {
+    auto name = g_db_replica_name->getValue();
+    if(!name.empty()) {
+        m_replica = std::make_shared<DBPool>(name);
+    }
+}
+
+sylar::IDB::ptr DBRouter::getWrite() {
+    return m_primary->get();
+}
+
+int64_t DBRouter::checkLag(uint64_t now) {
+    uint64_t last = m_lagTime;
+    if(last + g_db_replica_heartbeat_interval->getValue() > now
+            || !m_lagTime.compare_exchange_strong(last, now)) {
+        return m_lag;
+    }
+    int64_t pts = ReadHeartbeat(m_primary);
+    int64_t rts = pts < 0 ? -1 : ReadHeartbeat(m_replica);
+    int64_t lag = (pts < 0 || rts < 0) ? -1 : std::max(pts - rts, (int64_t)0);
+    m_lag = lag;
+    return lag;
+}
+
+sylar::IDB::ptr DBRouter::getRead() {
+    ++m_reads;
+    if(!m_replica) {
+        return m_primary->get();
+    }
+    int64_t lag = checkLag(sylar::GetCurrentMS());
+    if(lag >= 0 && lag <= (int64_t)g_db_replica_max_lag->getValue()) {
+        auto db = m_replica->get();
+        if(db) {
+            ++m_replicaReads;
+            return db;
+        }
+    }
+    ++m_fallbacks;
+    return m_primary->get();
+}
+
+void DBRouter::heartbeat() {
+    auto db = m_primary->get();
+    if(!db) {
+        return;
+    }
+    //副本与主库心跳时间戳之差即复制延迟
+    if(db->execute("replace into db_heartbeat (id, ts) values (1, "
+                + std::to_string(sylar::GetCurrentMS()) + ")")) {
+        SYLAR_LOG_WARN(g_logger) << "db heartbeat fail errno=" << db->getErrno()
+            << " errstr=" << db->getErrStr();
+    }
+}
+
+void DBRouter::start() {
+    if(!m_replica) {
+        return;
+    }
+    sylar::Mutex::Lock lock(m_mutex);
+    if(m_timer) {
+        return;
+    }
+    auto db = m_primary->get();
+    if(db && db->execute("create table if not exists db_heartbeat ("
+                "id bigint not null primary key, ts bigint not null default 0)")) {
+        SYLAR_LOG_ERROR(g_logger) << "create db_heartbeat fail errno=" << db->getErrno()
+            << " errstr=" << db->getErrStr();
+    }
+    heartbeat();
+    m_timer = sylar::IOManager::GetThis()->addTimer(g_db_replica_heartbeat_interval->getValue(),
+                std::bind(&DBRouter::heartbeat, this), true);
+}
+
+void DBRouter::stop() {
+    sylar::Mutex::Lock lock(m_mutex);
+    if(!m_timer) {
+        return;
+    }
+    m_timer->cancel();
+    m_timer = nullptr;
+}
+
+std::string DBRouter::statusString() {
+    std::stringstream ss;
+    ss << "DBRouter reads=" << m_reads
+       << " replica_reads=" << m_replicaReads
+       << " fallbacks=" << m_fallbacks
+       << " lag=" << m_lag
+       << std::endl;
+    ss << m_primary->statusString();
+    if(m_replica) {
+        ss << m_replica->statusString();
+    }
+    return ss.str();
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef __BLOG_DB_POOL_H__
+#define __BLOG_DB_POOL_H__
+
+#include "sylar/db/db.h"
+#include "sylar/singleton.h"
+#include "sylar/mutex.h"
+#include "sylar/timer.h"
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blog {
+
+//GetDB()背后的连接池, 空闲连接优先交给上次使用它的线程
+//每个连接按sql文本缓存prepare好的语句, DAO的静态sql只解析一次
+class DBPool {
+public:
+    typedef std::shared_ptr<DBPool> ptr;
+    DBPool(const std::string& name);
+
+    sylar::IDB::ptr get();
+
+    std::string statusString();
+private:
+    struct Conn {
+        Conn();
+        sylar::IDB::ptr db;
+        std::unordered_map<std::string, sylar::IStmt::ptr> stmts;
+        //本次借出用过的sqlite语句, 归还时reset, 避免停在SQLITE_ROW持有读事务
+        std::vector<sylar::IStmt::ptr> used;
+        uint64_t lastUsed;
+        pid_t tid;
+        bool suspect;
+    };
+
+    class PooledDB;
+
+    sylar::IDB::ptr create();
+    bool check(Conn* conn, uint64_t now);
+    void release(Conn* conn);
+    sylar::IStmt::ptr prepare(Conn* conn, const std::string& sql);
+    void markUsed(Conn* conn, sylar::IStmt::ptr stmt);
+private:
+    std::string m_name;
+    sylar::Mutex m_mutex;
+    std::list<Conn*> m_idle;
+    uint32_t m_total;
+
+    std::atomic<uint64_t> m_gets;
+    std::atomic<uint64_t> m_inUse;
+    std::atomic<uint64_t> m_created;
+    std::atomic<uint64_t> m_exhausted;
+    std::atomic<uint64_t> m_checkFails;
+    std::atomic<uint64_t> m_acquireUs;
+    std::atomic<uint64_t> m_maxAcquireUs;
+    std::atomic<uint64_t> m_stmtHits;
+    std::atomic<uint64_t> m_stmtMisses;
+};
+
+//读写分流, 写走主库blog
+//读优先走副本(db.replica.name), 副本不可用或延迟超过db.replica.max_lag时回退主库
+//延迟由主库定时写入的心跳时间戳与副本读到的差值估算
+class DBRouter {
+public:
+    DBRouter();
+
+    sylar::IDB::ptr getWrite();
+    sylar::IDB::ptr getRead();
+
+    void start();
+    void stop();
+
+    std::string statusString();
+private:
+    void heartbeat();
+    //返回副本延迟ms, -1表示未知; 到期时只有一个协程刷新, 其余直接用旧值
+    int64_t checkLag(uint64_t now);
+private:
+    DBPool::ptr m_primary;
+    DBPool::ptr m_replica;
+
+    //刷新要查两次库, 期间协程可能切换, 不能持锁, 用原子变量发布
+    std::atomic<int64_t> m_lag;
+    std::atomic<uint64_t> m_lagTime;
+
+    sylar::Mutex m_mutex;
+    sylar::Timer::ptr m_timer;
+
+    std::atomic<uint64_t> m_reads;
+    std::atomic<uint64_t> m_replicaReads;
+    std::atomic<uint64_t> m_fallbacks;
+};
+
+typedef sylar::Singleton<DBRouter> DBRouterMgr;
+
+}
+
+#endif
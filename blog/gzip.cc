@@ -0,0 +1,89 @@
+#include "gzip.h"
+#include "sylar/config.h"
+#include <string.h>
+#include <zlib.h>
+
+namespace blog {
+
+static sylar::ConfigVar<int32_t>::ptr g_gzip_level =
+    sylar::Config::Lookup("http.gzip.level", (int32_t)Z_DEFAULT_COMPRESSION, "http gzip compress level");
+
+GzipPiece::GzipPiece()
+    :crc(0)
+    ,len(0) {
+}
+
+bool GzipDeflate(const char* data, size_t len, GzipPiece& piece) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if(deflateInit2(&zs, g_gzip_level->getValue(), Z_DEFLATED, -MAX_WBITS
+                , 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    piece.data.resize(deflateBound(&zs, len) + 16);
+    zs.next_in = (Bytef*)data;
+    zs.avail_in = len;
+    size_t pos = 0;
+    int rt = Z_OK;
+    do {
+        if(pos == piece.data.size()) {
+            piece.data.resize(piece.data.size() * 2);
+        }
+        zs.next_out = (Bytef*)&piece.data[pos];
+        zs.avail_out = piece.data.size() - pos;
+        rt = deflate(&zs, Z_SYNC_FLUSH);
+        pos = piece.data.size() - zs.avail_out;
+    } while(rt == Z_OK && zs.avail_out == 0);
+    deflateEnd(&zs);
+    if(rt != Z_OK && rt != Z_BUF_ERROR) {
+        return false;
+    }
+    piece.data.resize(pos);
+    piece.crc = crc32(0, (const Bytef*)data, len);
+    piece.len = len;
+    return true;
+}
+
+GzipBuilder::GzipBuilder()
+    :m_crc(crc32(0, Z_NULL, 0))
+    ,m_len(0) {
+    static const char s_header[] = {
+        (char)0x1f, (char)0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3
+    };
+    m_out.append(s_header, sizeof(s_header));
+}
+
+bool GzipBuilder::add(const char* data, size_t len) {
+    if(!len) {
+        return true;
+    }
+    GzipPiece piece;
+    if(!GzipDeflate(data, len, piece)) {
+        return false;
+    }
+    add(piece);
+    return true;
+}
+
+void GzipBuilder::add(const GzipPiece& piece) {
+    m_out.append(piece.data);
+    m_crc = crc32_combine(m_crc, piece.crc, piece.len);
+    m_len += piece.len;
+}
+
+std::string GzipBuilder::finish() {
+    //空的final块(固定huffman), 结束deflate流
+    m_out.push_back((char)0x03);
+    m_out.push_back((char)0x00);
+    uint32_t vs[2] = {m_crc, (uint32_t)m_len};
+    for(auto v : vs) {
+        for(int i = 0; i < 4; ++i) {
+            m_out.push_back((char)((v >> (i * 8)) & 0xFF));
+        }
+    }
+    std::string rt;
+    rt.swap(m_out);
+    return rt;
+}
+
+}
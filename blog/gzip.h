@@ -0,0 +1,38 @@
+#ifndef __BLOG_GZIP_H__
+#define __BLOG_GZIP_H__
+
+#include <memory>
+#include <string>
+
+namespace blog {
+
+//独立压缩的raw deflate片段, 以sync flush结束且不引用其它片段的数据
+//多个片段按顺序拼接后仍是合法的deflate流, 用于复用预压缩的响应片段
+struct GzipPiece {
+    typedef std::shared_ptr<GzipPiece> ptr;
+    GzipPiece();
+
+    std::string data;
+    uint32_t crc;
+    uint64_t len;
+};
+
+bool GzipDeflate(const char* data, size_t len, GzipPiece& piece);
+
+//拼接若干片段输出完整的gzip数据
+class GzipBuilder {
+public:
+    GzipBuilder();
+
+    bool add(const char* data, size_t len);
+    void add(const GzipPiece& piece);
+    std::string finish();
+private:
+    std::string m_out;
+    uint32_t m_crc;
+    uint64_t m_len;
+};
+
+}
+
+#endif
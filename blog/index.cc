@@ -157,6 +157,9 @@ bool Index::set(uint64_t type, uint64_t key, uint32_t idx, bool v) {
 }
 
 sylar::ds::Bitmap::ptr Index::get(uint64_t type, uint64_t key) {
+    if(type == (uint64_t)IndexType::CAT_TREE) {
+        return getTree(key);
+    }
     auto it = m_indexs.find(type);
     if(it == m_indexs.end()) {
         return nullptr;
@@ -165,6 +168,46 @@ sylar::ds::Bitmap::ptr Index::get(uint64_t type, uint64_t key) {
     return iit == it->second.end() ? nullptr : iit->second;
 }
 
+sylar::ds::Bitmap::ptr Index::getTree(uint64_t key) {
+    auto forest = CategoryMgr::GetInstance()->getForest();
+    sylar::RWMutex::ReadLock lock(m_treeMutex);
+    if(m_forest == forest) {
+        auto it = m_trees.find(key);
+        if(it != m_trees.end()) {
+            return it->second;
+        }
+    }
+    lock.unlock();
+
+    //纯内存计算不会切换协程, 持写锁计算, 同一子树只算一次
+    sylar::RWMutex::WriteLock lock2(m_treeMutex);
+    if(m_forest != forest) {
+        m_forest = forest;
+        m_trees.clear();
+    }
+    auto it = m_trees.find(key);
+    if(it != m_trees.end()) {
+        return it->second;
+    }
+    sylar::ds::Bitmap::ptr b;
+    auto rit = forest->ranges.find(key);
+    if(rit != forest->ranges.end()) {
+        for(uint32_t n = rit->second.first; n < rit->second.second; ++n) {
+            auto t = get((uint64_t)IndexType::CAT_ID, forest->order[n]);
+            if(!t) {
+                continue;
+            }
+            if(!b) {
+                b = t->uncompress();
+            } else {
+                *b |= *t;
+            }
+        }
+    }
+    m_trees[key] = b;
+    return b;
+}
+
 void Index::build() {
     SYLAR_LOG_INFO(g_logger) << "Index build begin...";
     m_createTime = time(0);
@@ -181,8 +224,19 @@ void Index::build() {
     for(auto& info : infos) {
         m_docs.push_back(info->getId());
     }
+    std::unordered_map<int64_t, uint32_t> idxs;
     for(size_t i = 0; i < infos.size(); ++i) {
         buildIdx(infos[i], i);
+        idxs[infos[i]->getId()] = i;
+    }
+    //正文逐篇流式读取建索引, 不常驻内存
+    if(!ArticleMgr::GetInstance()->listContents([this, &idxs](int64_t id, const std::string& content) {
+        auto it = idxs.find(id);
+        if(it != idxs.end()) {
+            buildWordIdx(content, it->second);
+        }
+    })) {
+        SYLAR_LOG_ERROR(g_logger) << "Index build list contents fail";
     }
     m_endTime = time(0);
     SYLAR_LOG_INFO(g_logger) << "Index build over... used="
@@ -196,30 +250,27 @@ void Index::buildIdx(data::ArticleInfo::ptr info, uint32_t idx) {
     set((uint64_t)IndexType::CHANNEL, info->getChannel(), idx, true);
 
     buildWordIdx(info->getTitle(), idx);
-    buildWordIdx(info->getContent(), idx);
-
-    std::vector<data::ArticleCategoryRelInfo::ptr> cats;
-    ArticleCategoryRelMgr::GetInstance()->listByArticleId(cats, info->getId(), true);
-    for(auto& i : cats) {
-        auto cat = CategoryMgr::GetInstance()->get(i->getCategoryId());
-        if(!cat) {
-            SYLAR_LOG_ERROR(g_logger) << "invalid cat_id=" << i->getCategoryId();
-            continue;
+
+    auto cats = ArticleCategoryRelMgr::GetInstance()->getIndex()->listByArticleId(info->getId());
+    if(cats) {
+        for(auto& i : *cats) {
+            if(i.deleted) {
+                continue;
+            }
+            set((uint64_t)IndexType::CAT_ID, i.id, idx, true);
+            set((uint64_t)IndexType::CAT_NAME, hash(i.name.c_str(), true), idx, true);
         }
-        set((uint64_t)IndexType::CAT_ID, cat->getId(), idx, true);
-        set((uint64_t)IndexType::CAT_NAME, hash(cat->getName().c_str(), true), idx, true);
     }
 
-    std::vector<data::ArticleLabelRelInfo::ptr> labels;
-    ArticleLabelRelMgr::GetInstance()->listByArticleId(labels, info->getId(), true);
-    for(auto& i : labels) {
-        auto label = LabelMgr::GetInstance()->get(i->getLabelId());
-        if(!label) {
-            SYLAR_LOG_ERROR(g_logger) << "invalid label_id=" << i->getLabelId();
-            continue;
+    auto labels = ArticleLabelRelMgr::GetInstance()->getIndex()->listByArticleId(info->getId());
+    if(labels) {
+        for(auto& i : *labels) {
+            if(i.deleted) {
+                continue;
+            }
+            set((uint64_t)IndexType::LABEL_ID, i.id, idx, true);
+            set((uint64_t)IndexType::LABEL_NAME, hash(i.name.c_str(), true), idx, true);
         }
-        set((uint64_t)IndexType::LABEL_ID, label->getId(), idx, true);
-        set((uint64_t)IndexType::LABEL_NAME, hash(label->getName().c_str(), true), idx, true);
     }
 
 }
@@ -4,6 +4,7 @@
 #include "sylar/ds/bitmap.h"
 #include "sylar/mutex.h"
 #include "blog/manager/article_manager.h"
+#include "blog/manager/category_manager.h"
 #include "sylar/singleton.h"
 
 namespace blog {
@@ -17,6 +18,7 @@ enum class IndexType {
     STATE = 6,
     YEAR_MON = 7,
     CHANNEL = 8,
+    CAT_TREE = 9,
 
     WORD = 100
 };
@@ -30,6 +32,7 @@ enum class IndexType {
     XX("state",       IndexType::STATE,        1)\
     XX("yearmon",     IndexType::YEAR_MON,     2)\
     XX("channel",     IndexType::CHANNEL,      1)\
+    XX("cat_tree",    IndexType::CAT_TREE,     1)\
     XX("word",        IndexType::WORD,     2)\
 
 
@@ -69,12 +72,18 @@ private:
     uint64_t hash(const std::string& str, bool save);
 
     void buildWordIdx(const std::string& str, uint32_t idx);
+    //分类子树位图, 按需计算并缓存, 分类森林变化后清空
+    sylar::ds::Bitmap::ptr getTree(uint64_t key);
 private:
     uint64_t m_createTime;
     uint64_t m_endTime;
     std::vector<uint64_t> m_docs;
     std::map<uint64_t, std::map<uint64_t, sylar::ds::Bitmap::ptr> > m_indexs;
     std::unordered_map<uint64_t, std::string> m_strings;
+
+    sylar::RWMutex m_treeMutex;
+    CategoryManager::Forest::ptr m_forest;
+    std::unordered_map<uint64_t, sylar::ds::Bitmap::ptr> m_trees;
 };
 
 class IndexManager {
@@ -0,0 +1,215 @@
+#include "json_writer.h"
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+namespace blog {
+
+static const char s_hex[] = "0123456789abcdef";
+
+static void AppendUInt(std::string& buf, uint64_t v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    do {
+        *--p = '0' + (v % 10);
+        v /= 10;
+    } while(v);
+    buf.append(p, tmp + sizeof(tmp) - p);
+}
+
+JsonWriter::JsonWriter(std::string& buf)
+    :m_buf(buf)
+    ,m_afterKey(false) {
+}
+
+std::string& JsonWriter::Buffer() {
+    static thread_local std::string s_buf;
+    s_buf.clear();
+    return s_buf;
+}
+
+void JsonWriter::prefix() {
+    if(m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if(m_firsts.empty()) {
+        return;
+    }
+    if(m_firsts.back()) {
+        m_firsts.back() = false;
+    } else {
+        m_buf.push_back(',');
+    }
+}
+
+void JsonWriter::startObject() {
+    prefix();
+    m_buf.push_back('{');
+    m_firsts.push_back(true);
+}
+
+void JsonWriter::endObject() {
+    m_buf.push_back('}');
+    m_firsts.pop_back();
+}
+
+void JsonWriter::startArray() {
+    prefix();
+    m_buf.push_back('[');
+    m_firsts.push_back(true);
+}
+
+void JsonWriter::endArray() {
+    m_buf.push_back(']');
+    m_firsts.pop_back();
+}
+
+size_t JsonWriter::openObject(const std::string& frag) {
+    prefix();
+    size_t off = m_buf.size();
+    m_buf.append(frag);
+    m_firsts.push_back(frag.size() <= 1);
+    return off;
+}
+
+void JsonWriter::key(const char* str, size_t len) {
+    prefix();
+    escape(str, len);
+    m_buf.push_back(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::value(uint64_t v) {
+    prefix();
+    AppendUInt(m_buf, v);
+}
+
+void JsonWriter::value(int64_t v) {
+    prefix();
+    if(v < 0) {
+        m_buf.push_back('-');
+        AppendUInt(m_buf, (uint64_t)0 - (uint64_t)v);
+    } else {
+        AppendUInt(m_buf, v);
+    }
+}
+
+void JsonWriter::value(double v) {
+    if(!std::isfinite(v)) {
+        null();
+        return;
+    }
+    prefix();
+    char tmp[32];
+    int len = snprintf(tmp, sizeof(tmp), "%.17g", v);
+    m_buf.append(tmp, len);
+    //保证输出仍是浮点数形式
+    if(!strpbrk(tmp, ".eE")) {
+        m_buf.append(".0");
+    }
+}
+
+void JsonWriter::value(bool v) {
+    prefix();
+    m_buf.append(v ? "true" : "false");
+}
+
+void JsonWriter::null() {
+    prefix();
+    m_buf.append("null");
+}
+
+void JsonWriter::value(const char* str, size_t len) {
+    prefix();
+    escape(str, len);
+}
+
+void JsonWriter::value(const char* str) {
+    value(str, strlen(str));
+}
+
+void JsonWriter::raw(const std::string& str) {
+    prefix();
+    m_buf.append(str);
+}
+
+void JsonWriter::escape(const char* str, size_t len) {
+    m_buf.reserve(m_buf.size() + len + 2);
+    m_buf.push_back('"');
+    size_t begin = 0;
+    for(size_t i = 0; i < len; ++i) {
+        unsigned char c = str[i];
+        //快速路径: 普通字符批量追加
+        if(c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        m_buf.append(str + begin, i - begin);
+        begin = i + 1;
+        switch(c) {
+            case '"': m_buf.append("\\\""); break;
+            case '\\': m_buf.append("\\\\"); break;
+            case '\b': m_buf.append("\\b"); break;
+            case '\f': m_buf.append("\\f"); break;
+            case '\n': m_buf.append("\\n"); break;
+            case '\r': m_buf.append("\\r"); break;
+            case '\t': m_buf.append("\\t"); break;
+            default:
+                m_buf.append("\\u00");
+                m_buf.push_back(s_hex[c >> 4]);
+                m_buf.push_back(s_hex[c & 0xF]);
+                break;
+        }
+    }
+    m_buf.append(str + begin, len - begin);
+    m_buf.push_back('"');
+}
+
+void JsonWriter::value(const Json::Value& v) {
+    switch(v.type()) {
+        case Json::nullValue:
+            null();
+            break;
+        case Json::intValue:
+            value((int64_t)v.asInt64());
+            break;
+        case Json::uintValue:
+            value((uint64_t)v.asUInt64());
+            break;
+        case Json::realValue:
+            value(v.asDouble());
+            break;
+        case Json::booleanValue:
+            value(v.asBool());
+            break;
+        case Json::stringValue: {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            if(v.getString(&begin, &end)) {
+                value(begin, end - begin);
+            } else {
+                value("", 0);
+            }
+            break;
+        }
+        case Json::arrayValue:
+            startArray();
+            for(Json::ArrayIndex i = 0; i < v.size(); ++i) {
+                value(v[i]);
+            }
+            endArray();
+            break;
+        case Json::objectValue:
+            startObject();
+            for(auto it = v.begin(); it != v.end(); ++it) {
+                const char* end = nullptr;
+                const char* name = it.memberName(&end);
+                key(name, end - name);
+                value(*it);
+            }
+            endObject();
+            break;
+    }
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef __BLOG_JSON_WRITER_H__
+#define __BLOG_JSON_WRITER_H__
+
+#include <json/json.h>
+#include <string>
+#include <vector>
+
+namespace blog {
+
+//只追加的流式json输出, 直接写入调用方的buffer, 不构建DOM
+class JsonWriter {
+public:
+    JsonWriter(std::string& buf);
+
+    void startObject();
+    void endObject();
+    void startArray();
+    void endArray();
+    //写入去掉结尾'}'的对象片段, 之后可继续set, 以endObject结束
+    //返回片段在buffer中的起始偏移
+    size_t openObject(const std::string& frag);
+
+    void key(const char* str, size_t len);
+    void key(const std::string& str) { key(str.c_str(), str.size()); }
+
+    void value(int64_t v);
+    void value(uint64_t v);
+    void value(int32_t v) { value((int64_t)v); }
+    void value(uint32_t v) { value((uint64_t)v); }
+    void value(double v);
+    void value(bool v);
+    void value(const char* str, size_t len);
+    void value(const char* str);
+    void value(const std::string& str) { value(str.c_str(), str.size()); }
+    void value(const Json::Value& v);
+    void null();
+    //已序列化的json值
+    void raw(const std::string& str);
+
+    template<class T>
+    void set(const std::string& k, const T& v) {
+        key(k);
+        value(v);
+    }
+
+    template<class T>
+    void append(const T& v) {
+        value(v);
+    }
+
+    //当前线程复用的buffer, 仅供不会切换协程的一次性序列化使用
+    static std::string& Buffer();
+private:
+    void prefix();
+    void escape(const char* str, size_t len);
+private:
+    std::string& m_buf;
+    //每层是否还未写入元素
+    std::vector<bool> m_firsts;
+    bool m_afterKey;
+};
+
+}
+
+#endif
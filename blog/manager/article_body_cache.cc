@@ -0,0 +1,149 @@
+#include "article_body_cache.h"
+#include "blog/data/article_info.h"
+#include "blog/util.h"
+#include "blog/change_log.h"
+#include "sylar/log.h"
+#include "sylar/config.h"
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+static sylar::ConfigVar<uint64_t>::ptr g_body_cache_max_bytes =
+    sylar::Config::Lookup("article.body_cache.max_bytes",
+            (uint64_t)(64 * 1024 * 1024), "article body cache max bytes");
+
+ArticleBodyCache::ArticleBodyCache()
+    :m_bytes(0)
+    ,m_writeSeq(0)
+    ,m_hits(0)
+    ,m_misses(0) {
+}
+
+bool ArticleBodyCache::load(int64_t id, std::string& body) {
+    auto db = GetDB();
+    if(!db) {
+        SYLAR_LOG_ERROR(g_logger) << "get db fail";
+        return false;
+    }
+    auto info = data::ArticleInfoDao::Query(id, db);
+    if(!info) {
+        SYLAR_LOG_ERROR(g_logger) << "load article body fail id=" << id
+            << " errno=" << db->getErrno() << " errstr=" << db->getErrStr();
+        return false;
+    }
+    body = info->getContent();
+    return true;
+}
+
+void ArticleBodyCache::insert(int64_t id, const std::string& body, uint64_t seq, uint64_t lsn) {
+    uint64_t applied = ChangeLogMgr::GetInstance()->getAppliedLsn();
+    sylar::Mutex::Lock lock(m_mutex);
+    //加载期间有写入, 加载结果可能已过期, 不缓存
+    if(seq != m_writeSeq) {
+        return;
+    }
+    if(m_datas.count(id)) {
+        return;
+    }
+    m_lru.push_front(id);
+    Node& node = m_datas[id];
+    node.body = body;
+    node.pos = m_lru.begin();
+    node.lsn = lsn;
+    m_bytes += body.size();
+    //未刷库的正文跳过, 全部未刷库时允许暂时超出上限
+    auto pos = m_lru.end();
+    while(m_bytes > g_body_cache_max_bytes->getValue()
+            && pos != m_lru.begin() && std::prev(pos) != m_lru.begin()) {
+        --pos;
+        auto it = m_datas.find(*pos);
+        if(it->second.lsn > applied) {
+            continue;
+        }
+        m_bytes -= it->second.body.size();
+        m_datas.erase(it);
+        pos = m_lru.erase(pos);
+    }
+}
+
+bool ArticleBodyCache::get(int64_t id, std::string& body) {
+    sylar::Mutex::Lock lock(m_mutex);
+    auto it = m_datas.find(id);
+    if(it != m_datas.end()) {
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+        body = it->second.body;
+        return true;
+    }
+    ++m_misses;
+    uint64_t seq = m_writeSeq;
+    lock.unlock();
+
+    if(!load(id, body)) {
+        return false;
+    }
+    insert(id, body, seq, 0);
+    return true;
+}
+
+bool ArticleBodyCache::peek(int64_t id, std::string& body) {
+    sylar::Mutex::Lock lock(m_mutex);
+    auto it = m_datas.find(id);
+    if(it == m_datas.end()) {
+        return false;
+    }
+    body = it->second.body;
+    return true;
+}
+
+void ArticleBodyCache::put(int64_t id, const std::string& body, uint64_t lsn) {
+    sylar::Mutex::Lock lock(m_mutex);
+    ++m_writeSeq;
+    auto it = m_datas.find(id);
+    if(it != m_datas.end()) {
+        m_bytes -= it->second.body.size();
+        m_lru.erase(it->second.pos);
+        m_datas.erase(it);
+    }
+    uint64_t seq = m_writeSeq;
+    lock.unlock();
+    insert(id, body, seq, lsn);
+}
+
+void ArticleBodyCache::prefetch(const std::vector<int64_t>& ids) {
+    for(auto& i : ids) {
+        sylar::Mutex::Lock lock(m_mutex);
+        if(m_datas.count(i)) {
+            continue;
+        }
+        uint64_t seq = m_writeSeq;
+        lock.unlock();
+
+        std::string body;
+        if(load(i, body)) {
+            insert(i, body, seq, 0);
+        }
+    }
+}
+
+std::string ArticleBodyCache::statusString() {
+    std::stringstream ss;
+    uint64_t applied = ChangeLogMgr::GetInstance()->getAppliedLsn();
+    sylar::Mutex::Lock lock(m_mutex);
+    size_t pinned = 0;
+    for(auto& i : m_datas) {
+        if(i.second.lsn > applied) {
+            ++pinned;
+        }
+    }
+    ss << "ArticleBodyCache size=" << m_datas.size()
+       << " pinned=" << pinned
+       << " bytes=" << m_bytes
+       << " hits=" << m_hits
+       << " misses=" << m_misses
+       << std::endl;
+    lock.unlock();
+    return ss.str();
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef __BLOG_MANAGER_ARTICLE_BODY_CACHE_H__
+#define __BLOG_MANAGER_ARTICLE_BODY_CACHE_H__
+
+#include "sylar/mutex.h"
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blog {
+
+//文章正文缓存, 按字节数做LRU淘汰, 未命中时从数据库加载
+//put写入的正文在ChangeLog刷库前不淘汰, 避免淘汰后从数据库读到旧正文
+class ArticleBodyCache {
+public:
+    ArticleBodyCache();
+
+    bool get(int64_t id, std::string& body);
+    //只查缓存, 未命中不加载
+    bool peek(int64_t id, std::string& body);
+    //lsn: 正文所在ChangeLog记录的lsn, 刷库(applied >= lsn)前不淘汰
+    void put(int64_t id, const std::string& body, uint64_t lsn);
+    void prefetch(const std::vector<int64_t>& ids);
+
+    std::string statusString();
+private:
+    struct Node {
+        std::string body;
+        std::list<int64_t>::iterator pos;
+        uint64_t lsn;
+    };
+
+    bool load(int64_t id, std::string& body);
+    void insert(int64_t id, const std::string& body, uint64_t seq, uint64_t lsn);
+private:
+    sylar::Mutex m_mutex;
+    std::unordered_map<int64_t, Node> m_datas;
+    std::list<int64_t> m_lru;
+    uint64_t m_bytes;
+    uint64_t m_writeSeq;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+}
+
+#endif
@@ -5,23 +5,56 @@
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
 #include <map>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 namespace blog {
 
 class ArticleCategoryRelManager {
 public:
+    struct CategoryRef {
+        int64_t id;
+        std::string name;
+        bool deleted;
+    };
+    //有效关系的双向邻接表, 附带category名称和删除标记, 发布后只读
+    //关系变更只标记受影响的文章, 下次读取时由一个协程在旧快照的副本上增量修补后发布,
+    //构建期间其他读者继续用旧快照
+    struct Index {
+        typedef std::shared_ptr<const Index> ptr;
+        std::unordered_map<int64_t, std::vector<CategoryRef> > articles;
+        std::unordered_map<int64_t, std::vector<int64_t> > categorys;
+
+        const std::vector<CategoryRef>* listByArticleId(int64_t article_id) const;
+        const std::vector<int64_t>* listArticles(int64_t category_id) const;
+    };
+
+    ArticleCategoryRelManager();
     bool loadAll();
     void add(blog::data::ArticleCategoryRelInfo::ptr info);
     blog::data::ArticleCategoryRelInfo::ptr get(int64_t id);
     bool listByArticleId(std::vector<data::ArticleCategoryRelInfo::ptr>& infos, int64_t id, bool valid);
     blog::data::ArticleCategoryRelInfo::ptr getByArticleIdCategoryId(int64_t article_id, int64_t category_id);
 
+    Index::ptr getIndex();
+    //category名称/删除状态变化, 整体重建
+    void refresh();
+    //已有关系的is_deleted在原对象上修改后, 标记该文章需要修补
+    void refresh(int64_t article_id);
+
     std::string statusString();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::ArticleCategoryRelInfo::ptr> m_datas;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::ArticleCategoryRelInfo::ptr> > m_articles;
+    Index::ptr m_index;
+    std::set<int64_t> m_dirty;
+    bool m_full;
+    uint32_t m_builders;
+    uint64_t m_buildSeq;
+    uint64_t m_indexSeq;
+    uint64_t m_builds;
 };
 
 typedef sylar::Singleton<ArticleCategoryRelManager> ArticleCategoryRelMgr;
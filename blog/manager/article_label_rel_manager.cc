@@ -2,34 +2,49 @@
 #include "sylar/log.h"
 #include "sylar/util.h"
 #include "blog/util.h"
+#include "blog/manager/label_manager.h"
+#include "blog/manager/article_manager.h"
+#include <algorithm>
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
+ArticleLabelRelManager::ArticleLabelRelManager()
+    :m_full(true)
+    ,m_builders(0)
+    ,m_buildSeq(0)
+    ,m_indexSeq(0)
+    ,m_builds(0) {
+}
+
 bool ArticleLabelRelManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::ArticleLabelRelInfo::ptr> results;
-    if(blog::data::ArticleLabelRelInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "ArticleLabelRelManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::ArticleLabelRelInfo::ptr> datas;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::ArticleLabelRelInfo::ptr> > articles;
 
-    for(auto& i : results) {
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::ArticleLabelRelInfoDao::QueryAll([&](data::ArticleLabelRelInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
         articles[i->getArticleId()][i->getLabelId()] = i;
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "ArticleLabelRelManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "ArticleLabelRelManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
     m_articles.swap(articles);
+    m_dirty.clear();
+    m_full = true;
     return true;
 }
 
@@ -37,6 +52,170 @@ void ArticleLabelRelManager::add(blog::data::ArticleLabelRelInfo::ptr info) {
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas[info->getId()] = info;
     m_articles[info->getArticleId()][info->getLabelId()] = info;
+    m_dirty.insert(info->getArticleId());
+}
+
+void ArticleLabelRelManager::refresh() {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_full = true;
+}
+
+void ArticleLabelRelManager::refresh(int64_t article_id) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_dirty.insert(article_id);
+}
+
+const std::vector<ArticleLabelRelManager::LabelRef>*
+ArticleLabelRelManager::Index::listByArticleId(int64_t article_id) const {
+    auto it = articles.find(article_id);
+    return it == articles.end() ? nullptr : &it->second;
+}
+
+const std::vector<int64_t>*
+ArticleLabelRelManager::Index::listArticles(int64_t label_id) const {
+    auto it = labels.find(label_id);
+    return it == labels.end() ? nullptr : &it->second;
+}
+
+ArticleLabelRelManager::Index::ptr ArticleLabelRelManager::getIndex() {
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    if(m_index && (m_builders || (!m_full && m_dirty.empty()))) {
+        return m_index;
+    }
+    lock.unlock();
+
+    //取出变更的文章及其当前有效的label, 全量时取全部
+    std::unordered_map<int64_t, std::vector<int64_t> > changes;
+    sylar::RWMutex::WriteLock lock2(m_mutex);
+    if(m_index && (m_builders || (!m_full && m_dirty.empty()))) {
+        return m_index;
+    }
+    bool full = m_full || !m_index;
+    Index::ptr base = m_index;
+    auto collect = [&changes](int64_t id, const std::map<int64_t, blog::data::ArticleLabelRelInfo::ptr>& rels) {
+        auto& v = changes[id];
+        for(auto& r : rels) {
+            if(!r.second->getIsDeleted()) {
+                v.push_back(r.first);
+            }
+        }
+    };
+    if(full) {
+        for(auto& i : m_articles) {
+            collect(i.first, i.second);
+        }
+    } else {
+        for(auto& i : m_dirty) {
+            auto it = m_articles.find(i);
+            if(it == m_articles.end()) {
+                changes[i];
+            } else {
+                collect(i, it->second);
+            }
+        }
+    }
+    m_full = false;
+    m_dirty.clear();
+    ++m_builders;
+    uint64_t seq = ++m_buildSeq;
+    lock2.unlock();
+
+    std::shared_ptr<Index> idx(full ? new Index : new Index(*base));
+    if(!full) {
+        //先从反向表中摘掉旧关系
+        for(auto& c : changes) {
+            auto it = idx->articles.find(c.first);
+            if(it == idx->articles.end()) {
+                continue;
+            }
+            for(auto& r : it->second) {
+                auto& v = idx->labels[r.id];
+                auto vit = std::lower_bound(v.begin(), v.end(), c.first);
+                if(vit != v.end() && *vit == c.first) {
+                    v.erase(vit);
+                }
+                if(v.empty()) {
+                    idx->labels.erase(r.id);
+                }
+            }
+            idx->articles.erase(it);
+        }
+    }
+    for(auto& c : changes) {
+        if(c.second.empty()) {
+            continue;
+        }
+        auto& refs = idx->articles[c.first];
+        for(auto& i : c.second) {
+            LabelRef ref;
+            ref.id = i;
+            ref.deleted = true;
+            auto info = LabelMgr::GetInstance()->get(i);
+            if(info) {
+                ref.name = info->getName();
+                ref.deleted = info->getIsDeleted();
+            }
+            refs.push_back(ref);
+            auto& v = idx->labels[i];
+            if(full) {
+                v.push_back(c.first);
+            } else {
+                v.insert(std::lower_bound(v.begin(), v.end(), c.first), c.first);
+            }
+        }
+    }
+    if(full) {
+        for(auto& i : idx->labels) {
+            std::sort(i.second.begin(), i.second.end());
+        }
+    }
+
+    lock2.lock();
+    --m_builders;
+    ++m_builds;
+    //并发的全量构建可能晚于更新的构建完成, 只发布更新的结果
+    if(seq <= m_indexSeq) {
+        return idx;
+    }
+    m_index = idx;
+    m_indexSeq = seq;
+    lock2.unlock();
+
+    //发布后使关系有变化的文章渲染片段失效, 全量构建时与旧快照逐篇比较
+    std::vector<int64_t> changed;
+    if(!full) {
+        for(auto& c : changes) {
+            changed.push_back(c.first);
+        }
+    } else if(base) {
+        auto same = [](const std::vector<LabelRef>& a, const std::vector<LabelRef>& b) {
+            if(a.size() != b.size()) {
+                return false;
+            }
+            for(size_t i = 0; i < a.size(); ++i) {
+                if(a[i].id != b[i].id || a[i].deleted != b[i].deleted
+                        || a[i].name != b[i].name) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for(auto& i : idx->articles) {
+            auto it = base->articles.find(i.first);
+            if(it == base->articles.end() || !same(i.second, it->second)) {
+                changed.push_back(i.first);
+            }
+        }
+        for(auto& i : base->articles) {
+            if(!idx->articles.count(i.first)) {
+                changed.push_back(i.first);
+            }
+        }
+    }
+    if(!changed.empty()) {
+        ArticleMgr::GetInstance()->bumpRenders(changed);
+    }
+    return idx;
 }
 
 #define XX(map, key) \
@@ -77,7 +256,10 @@ std::string ArticleLabelRelManager::statusString() {
     std::stringstream ss;
     sylar::RWMutex::ReadLock lock(m_mutex);
     ss << "ArticleLabelRelManager total=" << m_datas.size()
-       << " articles=" << m_articles.size() << std::endl;
+       << " articles=" << m_articles.size()
+       << " index=" << (m_index ? 1 : 0)
+       << " dirty=" << m_dirty.size()
+       << " builds=" << m_builds << std::endl;
     lock.unlock();
     return ss.str();
 }
@@ -5,23 +5,56 @@
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
 #include <map>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 namespace blog {
 
 class ArticleLabelRelManager {
 public:
+    struct LabelRef {
+        int64_t id;
+        std::string name;
+        bool deleted;
+    };
+    //有效关系的双向邻接表, 附带label名称和删除标记, 发布后只读
+    //关系变更只标记受影响的文章, 下次读取时由一个协程在旧快照的副本上增量修补后发布,
+    //构建期间其他读者继续用旧快照
+    struct Index {
+        typedef std::shared_ptr<const Index> ptr;
+        std::unordered_map<int64_t, std::vector<LabelRef> > articles;
+        std::unordered_map<int64_t, std::vector<int64_t> > labels;
+
+        const std::vector<LabelRef>* listByArticleId(int64_t article_id) const;
+        const std::vector<int64_t>* listArticles(int64_t label_id) const;
+    };
+
+    ArticleLabelRelManager();
     bool loadAll();
     void add(blog::data::ArticleLabelRelInfo::ptr info);
     blog::data::ArticleLabelRelInfo::ptr get(int64_t id);
     blog::data::ArticleLabelRelInfo::ptr getByArticleIdLabelId(int64_t article_id, int64_t label_id);
     bool listByArticleId(std::vector<data::ArticleLabelRelInfo::ptr>& infos, int64_t article_id, bool valid);
 
+    Index::ptr getIndex();
+    //label名称/删除状态变化, 整体重建
+    void refresh();
+    //已有关系的is_deleted在原对象上修改后, 标记该文章需要修补
+    void refresh(int64_t article_id);
+
     std::string statusString();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::ArticleLabelRelInfo::ptr> m_datas;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::ArticleLabelRelInfo::ptr> > m_articles;
+    Index::ptr m_index;
+    std::set<int64_t> m_dirty;
+    bool m_full;
+    uint32_t m_builders;
+    uint64_t m_buildSeq;
+    uint64_t m_indexSeq;
+    uint64_t m_builds;
 };
 
 typedef sylar::Singleton<ArticleLabelRelManager> ArticleLabelRelMgr;
@@ -1,46 +1,167 @@
 #include "article_manager.h"
 #include "sylar/log.h"
 #include "sylar/util.h"
+#include "sylar/config.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
+#include "blog/manager/article_category_rel_manager.h"
+#include "blog/manager/article_label_rel_manager.h"
 #include "sylar/db/redis.h"
+#include <algorithm>
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+static sylar::ConfigVar<bool>::ptr g_article_compact_store =
+    sylar::Config::Lookup("article.compact_store", true, "article compact store enable");
+static sylar::ConfigVar<bool>::ptr g_article_body_offload =
+    sylar::Config::Lookup("article.body_offload", true, "article content not resident in memory");
+static sylar::ConfigVar<uint32_t>::ptr g_article_body_prefetch_size =
+    sylar::Config::Lookup("article.body_cache.prefetch_size",
+            (uint32_t)100, "article body cache prefetch top views size");
+static sylar::ConfigVar<uint32_t>::ptr g_article_publish_interval =
+    sylar::Config::Lookup("article.publish_interval",
+            (uint32_t)1000, "article scheduled publish check interval ms");
+static sylar::ConfigVar<uint32_t>::ptr g_article_delta_interval =
+    sylar::Config::Lookup("article.delta_refresh_interval",
+            (uint32_t)0, "article incremental reload interval ms, 0 disable");
+
+//复制除正文外的字段, 正文按需从m_bodies读取
+static data::ArticleInfo::ptr CopyMeta(data::ArticleInfo::ptr info) {
+    data::ArticleInfo::ptr v(new data::ArticleInfo);
+#define XX(f) v->set##f(info->get##f());
+    XX(Id) XX(UserId) XX(Title) XX(Type) XX(State) XX(Channel)
+    XX(IsDeleted) XX(PublishTime) XX(Weight) XX(Views) XX(Praise)
+    XX(Favorites) XX(CreateTime) XX(UpdateTime)
+#undef XX
+    return v;
+}
+
+ArticleManager::ArticleManager()
+    :m_lastUpdate(0) {
+}
 
 bool ArticleManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::ArticleInfo::ptr> results;
-    if(blog::data::ArticleInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "ArticleManager loadAll fail";
-        return false;
-    }
-
     std::map<int64_t, blog::data::ArticleInfo::ptr> datas;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::ArticleInfo::ptr> > users;
     std::map<int64_t, blog::data::ArticleInfo::ptr> verifys;
-
-    for(auto& i : results) {
+    ArticleStore store;
+    bool compact = g_article_compact_store->getValue();
+    bool offload = g_article_body_offload->getValue();
+    std::vector<Schedule> schedules;
+
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    int64_t last_update = 0;
+    auto cb = [&](data::ArticleInfo::ptr i) {
+        ++rows;
+        last_update = std::max(last_update, i->getUpdateTime());
+        if(compact) {
+            store.set(i);
+            store.setSummary(i->getId(), i->getContent());
+        }
+        if(offload) {
+            i = CopyMeta(i);
+        }
         datas[i->getId()] = i;
         users[i->getUserId()][i->getId()] = i;
         if(i->getState() == 1) {
             verifys[i->getId()] = i;
         }
+        if(i->getState() == (int)State::UNPUBLISH
+                && !i->getIsDeleted()) {
+            schedules.push_back(std::make_pair(i->getPublishTime(), i->getId()));
+        }
+    };
+    //正文不驻留时只查元数据列, content只带前100个字符用于摘要
+    int rt = offload
+        ? blog::data::ArticleInfoDao::QueryAllMeta(cb, db)
+        : blog::data::ArticleInfoDao::QueryAll(cb, db);
+    if(rt) {
+        SYLAR_LOG_ERROR(g_logger) << "ArticleManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "ArticleManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
     m_users.swap(users);
     m_verifys.swap(verifys);
+    m_lastUpdate = last_update;
+    lock.unlock();
+    m_store.swap(store);
+
+    ScheduleQueue tmp(std::greater<Schedule>(), std::move(schedules));
+    sylar::Mutex::Lock lock2(m_scheduleMutex);
+    m_schedules.swap(tmp);
+    return true;
+}
+
+bool ArticleManager::loadUpdated() {
+    auto db = GetDB();
+    if(!db) {
+        SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
+        return false;
+    }
+    int64_t since = 0;
+    {
+        sylar::RWMutex::ReadLock lock(m_mutex);
+        since = m_lastUpdate;
+    }
+    int64_t last_update = since;
+    std::vector<data::ArticleInfo::ptr> infos;
+    if(blog::data::ArticleInfoDao::QueryUpdatedSince([&](data::ArticleInfo::ptr i) {
+        last_update = std::max(last_update, i->getUpdateTime());
+        infos.push_back(i);
+    }, since, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "ArticleManager loadUpdated fail since=" << since;
+        return false;
+    }
+
+    size_t applied = 0;
+    for(auto& i : infos) {
+        //本地修改可能还在ChangeLog中未落库, 只接受比内存新的行
+        auto old = get(i->getId());
+        if(old && old->getUpdateTime() >= i->getUpdateTime()) {
+            continue;
+        }
+        if(i->getState() != 1 || i->getIsDeleted()) {
+            delVerify(i->getId());
+        }
+        add(i);
+        ++applied;
+    }
+
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_lastUpdate = std::max(m_lastUpdate, last_update);
+    lock.unlock();
+    if(applied) {
+        SYLAR_LOG_INFO(g_logger) << "ArticleManager loadUpdated since=" << since
+            << " rows=" << infos.size() << " applied=" << applied;
+    }
     return true;
 }
 
 void ArticleManager::add(blog::data::ArticleInfo::ptr info) {
+    if(!info->getContent().empty()) {
+        if(g_article_compact_store->getValue()) {
+            m_store.set(info);
+            m_store.setSummary(info->getId(), info->getContent());
+        }
+        if(g_article_body_offload->getValue()) {
+            //正文可能还在ChangeLog中未刷库, 刷库前不淘汰
+            m_bodies.put(info->getId(), info->getContent(),
+                    ChangeLogMgr::GetInstance()->getLsn());
+            info = CopyMeta(info);
+        }
+    }
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas[info->getId()] = info;
     m_users[info->getUserId()][info->getId()] = info;
@@ -48,6 +169,93 @@ void ArticleManager::add(blog::data::ArticleInfo::ptr info) {
             && info->getIsDeleted() == 0) {
         m_verifys[info->getId()] = info;
     }
+    lock.unlock();
+    refresh(info);
+}
+
+void ArticleManager::refresh(blog::data::ArticleInfo::ptr info) {
+    refreshStore(info);
+    updateNeighbors(info);
+    schedule(info);
+    m_renders.bump(info->getId());
+    m_versions.bump(info->getId(), info->getUserId());
+}
+
+bool ArticleManager::render(ArticleRenderCache::Type type, int64_t id
+                            ,ArticleRenderCache::Render cb, ArticleRenderCache::Fragment::ptr& frag) {
+    return m_renders.get(type, id, cb, frag);
+}
+
+void ArticleManager::bumpRenders(const std::vector<int64_t>& ids) {
+    m_renders.bump(ids);
+}
+
+void ArticleManager::refreshStore(blog::data::ArticleInfo::ptr info) {
+    if(g_article_compact_store->getValue()) {
+        m_store.set(info);
+    }
+}
+
+bool ArticleManager::getContent(int64_t id, std::string& content) {
+    if(g_article_body_offload->getValue()) {
+        return m_bodies.get(id, content);
+    }
+    auto info = get(id);
+    if(!info) {
+        return false;
+    }
+    content = info->getContent();
+    return true;
+}
+
+bool ArticleManager::peekContent(int64_t id, std::string& content) {
+    if(ChangeLogMgr::GetInstance()->getPendingContent(id, content)) {
+        return true;
+    }
+    if(g_article_body_offload->getValue()) {
+        return m_bodies.peek(id, content);
+    }
+    auto info = get(id);
+    if(!info) {
+        return false;
+    }
+    content = info->getContent();
+    return true;
+}
+
+bool ArticleManager::updateContent(blog::data::ArticleInfo::ptr info, const std::string& content) {
+    if(ChangeLogMgr::GetInstance()->update(info, content)) {
+        SYLAR_LOG_ERROR(g_logger) << "update content fail id=" << info->getId();
+        return false;
+    }
+    if(g_article_compact_store->getValue()) {
+        m_store.setSummary(info->getId(), content);
+    }
+    if(g_article_body_offload->getValue()) {
+        m_bodies.put(info->getId(), content, ChangeLogMgr::GetInstance()->getLsn());
+    } else {
+        info->setContent(content);
+    }
+    return true;
+}
+
+bool ArticleManager::listContents(std::function<void(int64_t, const std::string&)> cb) {
+    if(g_article_body_offload->getValue()) {
+        auto db = GetReadDB();
+        if(!db) {
+            SYLAR_LOG_ERROR(g_logger) << "get db fail";
+            return false;
+        }
+        //逐行读取, 不经过正文缓存
+        return data::ArticleInfoDao::QueryAll([&cb](data::ArticleInfo::ptr i) {
+            cb(i->getId(), i->getContent());
+        }, db) == 0;
+    }
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    for(auto& i : m_datas) {
+        cb(i.first, i.second->getContent());
+    }
+    return true;
 }
 
 void ArticleManager::delVerify(int64_t id) {
@@ -69,6 +277,54 @@ blog::data::ArticleInfo::ptr ArticleManager::get(int64_t id) {
     XX(m_datas, id);
 }
 
+bool ArticleManager::view(int64_t id, ArticleView& v, bool strings) {
+    if(g_article_compact_store->getValue()) {
+        return m_store.get(id, v, strings);
+    }
+    auto info = get(id);
+    if(!info) {
+        return false;
+    }
+    v.id = info->getId();
+    v.userId = info->getUserId();
+    v.channel = info->getChannel();
+    v.type = info->getType();
+    v.state = info->getState();
+    v.isDeleted = info->getIsDeleted();
+    v.publishTime = info->getPublishTime();
+    v.views = info->getViews();
+    v.praise = info->getPraise();
+    v.favorites = info->getFavorites();
+    v.updateTime = info->getUpdateTime();
+    if(!strings) {
+        v.title.clear();
+        v.summary.clear();
+        return true;
+    }
+    v.title = info->getTitle();
+    std::string content;
+    getContent(id, content);
+    v.summary = get_max_length_string(content, 100);
+    return true;
+}
+
+size_t ArticleManager::viewMany(const std::vector<int64_t>& ids, std::vector<ArticleView>& vs
+                                ,bool strings) {
+    if(g_article_compact_store->getValue()) {
+        return m_store.getMany(ids, vs, strings);
+    }
+    vs.resize(ids.size());
+    size_t count = 0;
+    for(size_t i = 0; i < ids.size(); ++i) {
+        if(view(ids[i], vs[i], strings)) {
+            ++count;
+        } else {
+            vs[i].id = 0;
+        }
+    }
+    return count;
+}
+
 bool ArticleManager::listByUserId(std::vector<data::ArticleInfo::ptr>& infos, int64_t id, bool valid) {
     sylar::RWMutex::ReadLock lock(m_mutex);
     auto it = m_users.find(id);
@@ -159,6 +415,11 @@ std::string ArticleManager::statusString() {
         ss << "    user(" << i.first << ") size=" << i.second.size() << std::endl;
     }
     lock.unlock();
+    ss << m_store.statusString();
+    ss << m_bodies.statusString();
+    ss << m_neighbors.statusString();
+    ss << m_interacts.statusString();
+    ss << m_renders.statusString();
     return ss.str();
 }
 
@@ -171,6 +432,12 @@ void ArticleManager::start() {
                 std::bind(&ArticleManager::onTimer, this), true);
     m_updateTimer = sylar::IOManager::GetThis()->addTimer(2 * 1000,
                 std::bind(&ArticleManager::onUpdateTimer, this), true);
+    m_publishTimer = sylar::IOManager::GetThis()->addTimer(g_article_publish_interval->getValue(),
+                std::bind(&ArticleManager::onPublishTimer, this), true);
+    if(g_article_delta_interval->getValue()) {
+        m_deltaTimer = sylar::IOManager::GetThis()->addTimer(g_article_delta_interval->getValue(),
+                    [this](){ loadUpdated(); }, true);
+    }
 }
 
 void ArticleManager::stop() {
@@ -183,6 +450,14 @@ void ArticleManager::stop() {
 
     m_updateTimer->cancel();
     m_updateTimer = nullptr;
+
+    m_publishTimer->cancel();
+    m_publishTimer = nullptr;
+
+    if(m_deltaTimer) {
+        m_deltaTimer->cancel();
+        m_deltaTimer = nullptr;
+    }
 }
 
 void ArticleManager::onUpdateTimer() {
@@ -195,92 +470,153 @@ void ArticleManager::onUpdateTimer() {
     if(updates.empty()) {
         return;
     }
-    auto conn = blog::GetDB();
-    if(!conn) {
-        SYLAR_LOG_ERROR(g_logger) << "get db connect fail";
-
+    std::vector<data::ArticleInfo::ptr> infos;
+    for(auto& i : updates) {
+        auto info = get(i);
+        if(info) {
+            infos.push_back(info);
+        }
+    }
+    if(ChangeLogMgr::GetInstance()->update(infos)) {
         sylar::RWMutex::WriteLock lock(m_viewsMutex);
         for(auto& i : updates) {
             m_updates.insert(i);
         }
-        return;
     }
-    for(auto& i : updates) {
-        auto info = get(i);
-        if(info) {
-            if(data::ArticleInfoDao::Update(info, conn)) {
-                addUpdate(i);
-            }
-        }
+}
+
+void ArticleManager::prefetchTrending() {
+    std::unordered_map<int64_t, int64_t> deltas;
+    {
+        sylar::RWMutex::WriteLock lock(m_viewsMutex);
+        deltas.swap(m_viewDeltas);
     }
+    if(!g_article_body_offload->getValue() || deltas.empty()) {
+        return;
+    }
+    std::vector<std::pair<int64_t, int64_t> > tops(deltas.begin(), deltas.end());
+    size_t size = std::min((size_t)g_article_body_prefetch_size->getValue(), tops.size());
+    std::partial_sort(tops.begin(), tops.begin() + size, tops.end(),
+            [](const std::pair<int64_t, int64_t>& a, const std::pair<int64_t, int64_t>& b) {
+        return a.second > b.second;
+    });
+    std::vector<int64_t> ids;
+    for(size_t i = 0; i < size; ++i) {
+        ids.push_back(tops[i].first);
+    }
+    m_bodies.prefetch(ids);
 }
 
 void ArticleManager::onTimer() {
+    prefetchTrending();
+}
+
+void ArticleManager::schedule(blog::data::ArticleInfo::ptr info) {
+    if(info->getState() != (int)State::UNPUBLISH
+            || info->getIsDeleted()) {
+        return;
+    }
+    sylar::Mutex::Lock lock(m_scheduleMutex);
+    m_schedules.push(std::make_pair(info->getPublishTime(), info->getId()));
+}
+
+void ArticleManager::onPublishTimer() {
     time_t now = time(0);
+    std::vector<int64_t> ids;
+    sylar::Mutex::Lock lock(m_scheduleMutex);
+    while(!m_schedules.empty() && m_schedules.top().first <= now) {
+        ids.push_back(m_schedules.top().second);
+        m_schedules.pop();
+    }
+    lock.unlock();
+    if(ids.empty()) {
+        return;
+    }
+
+    //堆中可能有改期或已删除的旧记录, 以当前状态为准
     std::vector<data::ArticleInfo::ptr> infos;
-    sylar::RWMutex::ReadLock lock(m_mutex);
-    for(auto& i : m_datas) {
-        if(i.second->getState() != (int)State::UNPUBLISH) {
+    sylar::RWMutex::WriteLock lock2(m_mutex);
+    for(auto& i : ids) {
+        auto it = m_datas.find(i);
+        if(it == m_datas.end()) {
             continue;
         }
-
-        if(i.second->getPublishTime() < now) {
-            i.second->setState((int)State::PUBLISH);
-            i.second->setUpdateTime(now);
-            infos.push_back(i.second);
+        auto& info = it->second;
+        if(info->getState() != (int)State::UNPUBLISH
+                || info->getIsDeleted()
+                || info->getPublishTime() > now) {
+            continue;
         }
+        info->setState((int)State::PUBLISH);
+        info->setUpdateTime(now);
+        infos.push_back(info);
     }
-    lock.unlock();
+    lock2.unlock();
 
     if(infos.empty()) {
         return;
     }
-    auto db = GetDB();
-    if(!db) {
-        SYLAR_LOG_ERROR(g_logger) << "getDB error";
-        return;
-    }
     for(auto& i : infos) {
-        if(data::ArticleInfoDao::Update(i, db)) {
-            SYLAR_LOG_ERROR(g_logger) << "Update error errno="
-                << db->getErrno() << " errstr=" << db->getErrStr()
-                << " data=" << i->toJsonString();
-        }
+        refresh(i);
+    }
+    if(ChangeLogMgr::GetInstance()->update(infos)) {
+        SYLAR_LOG_ERROR(g_logger) << "update publish state fail size=" << infos.size();
+    }
+}
+
+bool ArticleManager::nearby(int64_t id, ArticleView& prev, ArticleView& next
+                            ,ArticleNeighbors::Type type, int64_t key) {
+    //邻居表只收已发布文章, 不存在或已删除的id不应有前后篇
+    auto info = get(id);
+    if(!info || info->getIsDeleted()) {
+        return false;
+    }
+    int64_t prev_id = 0;
+    int64_t next_id = 0;
+    if(!m_neighbors.nearby(type, key, id, prev_id, next_id)) {
+        return false;
+    }
+    if(prev_id) {
+        view(prev_id, prev);
     }
+    if(next_id) {
+        view(next_id, next);
+    }
+    return true;
 }
 
-std::pair<data::ArticleInfo::ptr, data::ArticleInfo::ptr> ArticleManager::nearby(int64_t id) {
+void ArticleManager::buildNeighbors() {
+    std::vector<data::ArticleInfo::ptr> infos;
     sylar::RWMutex::ReadLock lock(m_mutex);
-    auto it = m_datas.find(id);
-    if(it == m_datas.end()) {
-        return std::make_pair(nullptr, nullptr);
-    }
-    data::ArticleInfo::ptr next;
-    auto iit = it;
-    ++iit;
-    for(;iit != m_datas.end(); ++iit) {
-        if(iit->second->getIsDeleted()) {
-            continue;
-        }
-        if(iit->second->getState() == (int)State::PUBLISH) {
-            next = iit->second;
-            break;
-        }
+    for(auto& i : m_datas) {
+        infos.push_back(i.second);
+    }
+    lock.unlock();
+    for(auto& i : infos) {
+        updateNeighbors(i);
     }
+}
 
-    data::ArticleInfo::ptr prev;
-    SYLAR_ASSERT(id == it->first);
-    while(it != m_datas.begin()) {
-        --it;
-        if(it->second->getIsDeleted()) {
-            continue;
+void ArticleManager::updateNeighbors(data::ArticleInfo::ptr info) {
+    ArticleNeighbors::Member m;
+    m.published = info->getState() == (int)State::PUBLISH
+                    && !info->getIsDeleted();
+    m.userId = info->getUserId();
+    m.channel = info->getChannel();
+    if(m.published) {
+        //直接读关系表, 关系索引快照可能还没修补到这篇文章
+        std::vector<data::ArticleCategoryRelInfo::ptr> cats;
+        ArticleCategoryRelMgr::GetInstance()->listByArticleId(cats, info->getId(), true);
+        for(auto& i : cats) {
+            m.categorys.insert(i->getCategoryId());
         }
-        if(it->second->getState() == (int)State::PUBLISH) {
-            prev = it->second;
-            break;
+        std::vector<data::ArticleLabelRelInfo::ptr> labels;
+        ArticleLabelRelMgr::GetInstance()->listByArticleId(labels, info->getId(), true);
+        for(auto& i : labels) {
+            m.labels.insert(i->getLabelId());
         }
     }
-    return std::make_pair(prev, next);
+    m_neighbors.update(info->getId(), m);
 }
 
 bool ArticleManager::addViews(uint64_t id, const std::string& cooke_id) {
@@ -297,6 +633,7 @@ bool ArticleManager::addViews(uint64_t id, const std::string& cooke_id) {
 
     sylar::RWMutex::WriteLock lock2(m_viewsMutex);
     m_viewsCache[id][cooke_id] = now;
+    ++m_viewDeltas[id];
     return true;
 }
 
@@ -313,153 +650,114 @@ bool ArticleManager::incViews(uint64_t id, const std::string& cooke_id, uint64_t
     bool v = addViews(id, cooke_id);
     if(v) {
         info->setViews(info->getViews() + 1);
+        refreshStore(info);
         addUpdate(id);
     }
     return true;
 }
 
-bool ArticleManager::incPraise(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
-    auto info = get(id);
-    if(!info) {
-        return false;
-    }
-    auto rpy = sylar::RedisUtil::Cmd("blog", "hexists pra_a2u:%lld %lld", id, user_id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hexists fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        return true;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hset pra_a2u:%lld %lld %lld", id, user_id, time(0));
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hset pra_u2a:%lld %lld %lld", user_id, id, time(0));
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    info->setPraise(info->getPraise() + 1);
-    addUpdate(id);
+//a2u与u2a两个标记在一个脚本里原子写入, 以a2u的hsetnx结果为准决定是否计数
+//多实例或本地缓存过期时同一操作也只会计一次
+static const char* s_interact_add_script =
+    "if redis.call('hsetnx', KEYS[1], ARGV[1], ARGV[3]) == 1 then "
+    "redis.call('hset', KEYS[2], ARGV[2], ARGV[3]) return 1 end "
+    "redis.call('hsetnx', KEYS[2], ARGV[2], ARGV[3]) return 0";
 
+static const char* s_interact_del_script =
+    "local v = redis.call('hdel', KEYS[1], ARGV[1]) "
+    "redis.call('hdel', KEYS[2], ARGV[2]) return v";
+
+#define INC(id, user_id, a2u, u2a, setter, getter, key) \
+    auto info = get(id); \
+    if(!info) { \
+        return false; \
+    } \
+    int64_t now = time(0); \
+    auto rpy = sylar::RedisUtil::Cmd("blog", "eval %s 2 " key "_a2u:%lld " key "_u2a:%lld %lld %lld %lld" \
+            ,s_interact_add_script, id, user_id, user_id, id, now); \
+    if(!rpy || rpy->type != REDIS_REPLY_INTEGER) { \
+        SYLAR_LOG_ERROR(g_logger) << "eval " key " add fail id=" << id << " user_id=" << user_id; \
+        m_interacts.invalidate(InteractCache::a2u, id); \
+        m_interacts.invalidate(InteractCache::u2a, user_id); \
+        return false; \
+    } \
+    if(rpy->integer != 1) { \
+        return true; \
+    } \
+    m_interacts.add(InteractCache::a2u, id, user_id, now); \
+    m_interacts.add(InteractCache::u2a, user_id, id, now); \
+    info->setter(info->getter() + 1); \
+    refreshStore(info); \
+    addUpdate(id); \
     return true;
+
+bool ArticleManager::incPraise(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
+    INC(id, user_id, PRA_A2U, PRA_U2A, setPraise, getPraise, "pra");
 }
 
 bool ArticleManager::incFavorites(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
-    auto info = get(id);
-    if(!info) {
-        return false;
-    }
-    auto rpy = sylar::RedisUtil::Cmd("blog", "hexists fav_a2u:%lld %lld", id, user_id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hexists fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        return true;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hset fav_a2u:%lld %lld %lld", id, user_id, time(0));
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hset fav_u2a:%lld %lld %lld", user_id, id, time(0));
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    info->setFavorites(info->getFavorites() + 1);
-    addUpdate(id);
-    return true;
+    INC(id, user_id, FAV_A2U, FAV_U2A, setFavorites, getFavorites, "fav");
 }
+#undef INC
 
-bool ArticleManager::decPraise(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
-    auto info = get(id);
-    if(!info) {
-        return false;
-    }
-    bool v = false;
-    auto rpy = sylar::RedisUtil::Cmd("blog", "hdel pra_a2u:%lld %lld", id, user_id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        v = true;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hdel pra_u2a:%lld %lld", user_id, id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        v = true;
-    }
-    if(v) {
-        info->setPraise(info->getPraise() - 1);
-        addUpdate(id);
-    }
+#define DEC(id, user_id, a2u, u2a, setter, getter, key) \
+    auto info = get(id); \
+    if(!info) { \
+        return false; \
+    } \
+    auto rpy = sylar::RedisUtil::Cmd("blog", "eval %s 2 " key "_a2u:%lld " key "_u2a:%lld %lld %lld" \
+            ,s_interact_del_script, id, user_id, user_id, id); \
+    if(!rpy || rpy->type != REDIS_REPLY_INTEGER) { \
+        SYLAR_LOG_ERROR(g_logger) << "eval " key " del fail id=" << id << " user_id=" << user_id; \
+        m_interacts.invalidate(InteractCache::a2u, id); \
+        m_interacts.invalidate(InteractCache::u2a, user_id); \
+        return false; \
+    } \
+    m_interacts.del(InteractCache::a2u, id, user_id); \
+    m_interacts.del(InteractCache::u2a, user_id, id); \
+    if(rpy->integer == 1) { \
+        info->setter(info->getter() - 1); \
+        refreshStore(info); \
+        addUpdate(id); \
+    } \
     return true;
+
+bool ArticleManager::decPraise(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
+    DEC(id, user_id, PRA_A2U, PRA_U2A, setPraise, getPraise, "pra");
 }
 
 bool ArticleManager::decFavorites(uint64_t id, const std::string& cooke_id, uint64_t user_id) {
-    auto info = get(id);
-    if(!info) {
-        return false;
-    }
-    bool v = false;
-    auto rpy = sylar::RedisUtil::Cmd("blog", "hdel fav_a2u:%lld %lld", id, user_id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        v = true;
-    }
-    rpy = sylar::RedisUtil::Cmd("blog", "hset fav_u2a:%lld %lld", user_id, id);
-    if(!rpy) {
-        SYLAR_LOG_ERROR(g_logger) << "hset fail";
-        return false;
-    }
-    if(rpy->integer == 1) {
-        v = true;
-    }
-    if(v) {
-        info->setFavorites(info->getFavorites() - 1);
-        addUpdate(id);
-    }
-    return true;
+    DEC(id, user_id, FAV_A2U, FAV_U2A, setFavorites, getFavorites, "fav");
 }
+#undef DEC
 
 bool ArticleManager::listUserFav(int64_t id, std::map<int64_t, int64_t>& articles) {
-#define PROC(id, mask, articles) \
-    auto rpy = sylar::RedisUtil::Cmd("blog", mask, id); \
-    if(!rpy) { \
-        SYLAR_LOG_ERROR(g_logger) << "hgetall fail"; \
-        return false; \
-    } \
-    for(size_t i = 0; i < rpy->elements; i += 2) { \
-        articles[sylar::TypeUtil::Atoi(rpy->element[i]->str)] \
-            = sylar::TypeUtil::Atoi(rpy->element[i + 1]->str); \
-    } \
-    return true;
-    PROC(id, "hgetall fav_u2a:%lld", articles);
+    return m_interacts.get(InteractCache::FAV_U2A, id, articles);
 }
 
 bool ArticleManager::listUserPra(int64_t id, std::map<int64_t, int64_t>& articles) {
-    PROC(id, "hgetall pra_u2a:%lld", articles);
+    return m_interacts.get(InteractCache::PRA_U2A, id, articles);
 }
 
 bool ArticleManager::listArticleFav(int64_t id, std::map<int64_t, int64_t>& users) {
-    PROC(id, "hgetall fav_a2u:%lld", users);
+    return m_interacts.get(InteractCache::FAV_A2U, id, users);
 }
 
 bool ArticleManager::listArticlePra(int64_t id, std::map<int64_t, int64_t>& users) {
-    PROC(id, "hgetall pra_a2u:%lld", users);
+    return m_interacts.get(InteractCache::PRA_A2U, id, users);
+}
+
+bool ArticleManager::hasPraise(int64_t id, int64_t user_id) {
+    bool exists = false;
+    m_interacts.exists(InteractCache::PRA_U2A, user_id, id, exists);
+    return exists;
+}
+
+bool ArticleManager::hasFavorites(int64_t id, int64_t user_id) {
+    bool exists = false;
+    m_interacts.exists(InteractCache::FAV_U2A, user_id, id, exists);
+    return exists;
 }
-#undef PROC
 
 #undef XX
 
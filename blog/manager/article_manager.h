@@ -2,19 +2,47 @@
 #define __BLOG_MANAGER_ARTICLE_MANAGER_H__
 
 #include "blog/data/article_info.h"
+#include "blog/manager/interact_cache.h"
+#include "blog/manager/article_store.h"
+#include "blog/manager/article_body_cache.h"
+#include "blog/manager/article_neighbors.h"
+#include "blog/manager/article_render_cache.h"
+#include "blog/manager/entity_version.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
 #include "sylar/iomanager.h"
 #include <map>
 #include <unordered_map>
+#include <queue>
 
 namespace blog {
 
 class ArticleManager {
 public:
+    //定时发布队列, (publish_time, id)最小堆
+    typedef std::pair<int64_t, int64_t> Schedule;
+    typedef std::priority_queue<Schedule, std::vector<Schedule>
+                                ,std::greater<Schedule> > ScheduleQueue;
+
+    ArticleManager();
+
     bool loadAll();
+    //增量加载update_time不早于上次加载的行
+    bool loadUpdated();
     void add(blog::data::ArticleInfo::ptr info);
     blog::data::ArticleInfo::ptr get(int64_t id);
+    //strings=false时不填标题和摘要, 未开启compact_store时也不读正文
+    bool view(int64_t id, ArticleView& v, bool strings = true);
+    size_t viewMany(const std::vector<int64_t>& ids, std::vector<ArticleView>& vs
+                    ,bool strings = true);
+    void refresh(blog::data::ArticleInfo::ptr info);
+    uint64_t getVersion(int64_t id) { return m_versions.get(id); }
+
+    bool getContent(int64_t id, std::string& content);
+    //只取内存中的正文(未刷库的ChangeLog记录, 正文缓存或内存对象), 不读数据库
+    bool peekContent(int64_t id, std::string& content);
+    bool updateContent(blog::data::ArticleInfo::ptr info, const std::string& content);
+    bool listContents(std::function<void(int64_t, const std::string&)> cb);
     bool listByUserId(std::vector<data::ArticleInfo::ptr>& infos, int64_t id, bool valid);
     int64_t listByUserIdPages(std::vector<data::ArticleInfo::ptr>& infos, int64_t id
                               ,int32_t offset, int32_t size, bool valid, int state);
@@ -25,7 +53,14 @@ public:
     int64_t listVerifyPages(std::vector<data::ArticleInfo::ptr>& infos
                             ,int32_t offset, int32_t size);
 
-    std::pair<data::ArticleInfo::ptr, data::ArticleInfo::ptr> nearby(int64_t id);
+    bool render(ArticleRenderCache::Type type, int64_t id
+                ,ArticleRenderCache::Render cb, ArticleRenderCache::Fragment::ptr& frag);
+    //关系索引发布后, 使分类/标签有变化的文章片段失效
+    void bumpRenders(const std::vector<int64_t>& ids);
+
+    bool nearby(int64_t id, ArticleView& prev, ArticleView& next
+                ,ArticleNeighbors::Type type = ArticleNeighbors::GLOBAL, int64_t key = 0);
+    void buildNeighbors();
 
     std::string statusString();
     void start();
@@ -41,11 +76,19 @@ public:
     bool listUserPra(int64_t id, std::map<int64_t, int64_t>& articles);
     bool listArticleFav(int64_t id, std::map<int64_t, int64_t>& users);
     bool listArticlePra(int64_t id, std::map<int64_t, int64_t>& users);
+
+    bool hasPraise(int64_t id, int64_t user_id);
+    bool hasFavorites(int64_t id, int64_t user_id);
 private:
     void onTimer();
+    void onPublishTimer();
+    void schedule(blog::data::ArticleInfo::ptr info);
     void onUpdateTimer();
     bool addViews(uint64_t id, const std::string& cooke_id);
     void addUpdate(int64_t id);
+    void refreshStore(blog::data::ArticleInfo::ptr info);
+    void updateNeighbors(blog::data::ArticleInfo::ptr info);
+    void prefetchTrending();
 private:
     sylar::RWMutex m_mutex;
     std::map<int64_t, blog::data::ArticleInfo::ptr> m_datas;
@@ -54,8 +97,20 @@ private:
     sylar::RWMutex m_viewsMutex;
     std::map<int64_t, std::map<std::string, int64_t> > m_viewsCache;
     std::set<int64_t> m_updates;
+    std::unordered_map<int64_t, int64_t> m_viewDeltas;
     sylar::Timer::ptr m_timer;
     sylar::Timer::ptr m_updateTimer;
+    sylar::Timer::ptr m_publishTimer;
+    sylar::Timer::ptr m_deltaTimer;
+    int64_t m_lastUpdate;
+    sylar::Mutex m_scheduleMutex;
+    ScheduleQueue m_schedules;
+    InteractCache m_interacts;
+    ArticleStore m_store;
+    ArticleBodyCache m_bodies;
+    ArticleNeighbors m_neighbors;
+    ArticleRenderCache m_renders;
+    EntityVersion m_versions;
 };
 
 typedef sylar::Singleton<ArticleManager> ArticleMgr;
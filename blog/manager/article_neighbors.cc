@@ -0,0 +1,95 @@
+#include "article_neighbors.h"
+#include <sstream>
+
+namespace blog {
+
+ArticleNeighbors::Member::Member()
+    :published(false)
+    ,userId(0)
+    ,channel(0) {
+}
+
+void ArticleNeighbors::add(const Scope& scope, int64_t id) {
+    m_lists[scope].insert(id);
+}
+
+void ArticleNeighbors::del(const Scope& scope, int64_t id) {
+    auto it = m_lists.find(scope);
+    if(it == m_lists.end()) {
+        return;
+    }
+    it->second.erase(id);
+    if(it->second.empty()) {
+        m_lists.erase(it);
+    }
+}
+
+void ArticleNeighbors::apply(int64_t id, const Member& m, bool v) {
+    if(!m.published) {
+        return;
+    }
+#define XX(type, key) \
+    if(v) { \
+        add(Scope(type, key), id); \
+    } else { \
+        del(Scope(type, key), id); \
+    }
+    XX(GLOBAL, 0);
+    XX(USER, m.userId);
+    XX(CHANNEL, m.channel);
+    for(auto& i : m.categorys) {
+        XX(CATEGORY, i);
+    }
+    for(auto& i : m.labels) {
+        XX(LABEL, i);
+    }
+#undef XX
+}
+
+void ArticleNeighbors::update(int64_t id, const Member& m) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    auto it = m_members.find(id);
+    if(it != m_members.end()) {
+        apply(id, it->second, false);
+    }
+    apply(id, m, true);
+    if(m.published) {
+        m_members[id] = m;
+    } else if(it != m_members.end()) {
+        m_members.erase(it);
+    }
+}
+
+bool ArticleNeighbors::nearby(Type type, int64_t key, int64_t id, int64_t& prev, int64_t& next) {
+    prev = next = 0;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    auto it = m_lists.find(Scope(type, key));
+    if(it == m_lists.end()) {
+        return false;
+    }
+    auto& list = it->second;
+    auto iit = list.lower_bound(id);
+    auto nit = iit;
+    if(nit != list.end() && *nit == id) {
+        ++nit;
+    }
+    if(nit != list.end()) {
+        next = *nit;
+    }
+    if(iit != list.begin()) {
+        --iit;
+        prev = *iit;
+    }
+    return true;
+}
+
+std::string ArticleNeighbors::statusString() {
+    std::stringstream ss;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    ss << "ArticleNeighbors published=" << m_members.size()
+       << " lists=" << m_lists.size()
+       << std::endl;
+    return ss.str();
+}
+
+}
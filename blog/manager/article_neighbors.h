@@ -0,0 +1,52 @@
+#ifndef __BLOG_MANAGER_ARTICLE_NEIGHBORS_H__
+#define __BLOG_MANAGER_ARTICLE_NEIGHBORS_H__
+
+#include "sylar/mutex.h"
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace blog {
+
+//已发布文章按id有序的前后邻居, 分全局/用户/频道/分类/标签维护
+//状态变化时增量更新, 查询前后篇不再扫描全部文章
+class ArticleNeighbors {
+public:
+    enum Type {
+        GLOBAL   = 0,
+        USER     = 1,
+        CHANNEL  = 2,
+        CATEGORY = 3,
+        LABEL    = 4
+    };
+
+    struct Member {
+        Member();
+        bool published;
+        int64_t userId;
+        int64_t channel;
+        std::set<int64_t> categorys;
+        std::set<int64_t> labels;
+    };
+
+    void update(int64_t id, const Member& m);
+    bool nearby(Type type, int64_t key, int64_t id, int64_t& prev, int64_t& next);
+
+    std::string statusString();
+private:
+    typedef std::pair<int, int64_t> Scope;
+    typedef std::set<int64_t> List;
+
+    void add(const Scope& scope, int64_t id);
+    void del(const Scope& scope, int64_t id);
+    void apply(int64_t id, const Member& m, bool v);
+private:
+    sylar::RWMutex m_mutex;
+    std::map<Scope, List> m_lists;
+    std::unordered_map<int64_t, Member> m_members;
+};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "article_render_cache.h"
+#include "sylar/config.h"
+#include "blog/json_writer.h"
+#include <sstream>
+
+namespace blog {
+
+static sylar::ConfigVar<uint64_t>::ptr g_render_cache_max_bytes =
+    sylar::Config::Lookup("article.render_cache.max_bytes",
+            (uint64_t)(32 * 1024 * 1024), "article render cache max bytes");
+
+static sylar::ConfigVar<uint32_t>::ptr g_render_cache_gzip_min_size =
+    sylar::Config::Lookup("article.render_cache.gzip_min_size",
+            (uint32_t)512, "article render cache gzip min size");
+
+static uint64_t MakeKey(ArticleRenderCache::Type type, int64_t id) {
+    return ((uint64_t)id << 1) | (uint64_t)type;
+}
+
+static size_t FragmentSize(ArticleRenderCache::Fragment::ptr frag) {
+    return frag->json.size() + (frag->gzip ? frag->gzip->data.size() : 0);
+}
+
+ArticleRenderCache::ArticleRenderCache()
+    :m_bytes(0)
+    ,m_hits(0)
+    ,m_misses(0) {
+}
+
+void ArticleRenderCache::erase(uint64_t key) {
+    auto it = m_datas.find(key);
+    if(it == m_datas.end()) {
+        return;
+    }
+    m_bytes -= FragmentSize(it->second.frag);
+    m_lru.erase(it->second.pos);
+    m_datas.erase(it);
+}
+
+void ArticleRenderCache::insert(uint64_t key, int64_t id, Fragment::ptr frag, uint64_t version) {
+    sylar::Mutex::Lock lock(m_mutex);
+    //渲染期间文章有变更, 结果可能已过期, 不缓存
+    auto it = m_versions.find(id);
+    if(version != (it == m_versions.end() ? 0 : it->second)) {
+        return;
+    }
+    if(m_datas.count(key)) {
+        return;
+    }
+    m_lru.push_front(key);
+    Node& node = m_datas[key];
+    node.frag = frag;
+    node.pos = m_lru.begin();
+    m_bytes += FragmentSize(frag);
+    while(m_bytes > g_render_cache_max_bytes->getValue() && m_lru.size() > 1) {
+        erase(m_lru.back());
+    }
+}
+
+bool ArticleRenderCache::get(Type type, int64_t id, Render render, Fragment::ptr& frag) {
+    uint64_t key = MakeKey(type, id);
+    sylar::Mutex::Lock lock(m_mutex);
+    auto it = m_datas.find(key);
+    if(it != m_datas.end()) {
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+        frag = it->second.frag;
+        return true;
+    }
+    ++m_misses;
+    auto vit = m_versions.find(id);
+    uint64_t version = vit == m_versions.end() ? 0 : vit->second;
+    lock.unlock();
+
+    Json::Value v;
+    if(!render(v)) {
+        return false;
+    }
+    if(!v.isObject()) {
+        return false;
+    }
+    std::shared_ptr<Fragment> tmp(new Fragment);
+    JsonWriter w(tmp->json);
+    w.value(v);
+    tmp->json.resize(tmp->json.size() - 1);
+    if(tmp->json.size() >= g_render_cache_gzip_min_size->getValue()) {
+        tmp->gzip.reset(new GzipPiece);
+        if(!GzipDeflate(tmp->json.c_str(), tmp->json.size(), *tmp->gzip)) {
+            tmp->gzip.reset();
+        }
+    }
+    frag = tmp;
+    insert(key, id, frag, version);
+    return true;
+}
+
+void ArticleRenderCache::bumpLocked(int64_t id) {
+    ++m_versions[id];
+    erase(MakeKey(SNAPPY, id));
+    erase(MakeKey(DETAIL, id));
+}
+
+void ArticleRenderCache::bump(int64_t id) {
+    sylar::Mutex::Lock lock(m_mutex);
+    bumpLocked(id);
+}
+
+void ArticleRenderCache::bump(const std::vector<int64_t>& ids) {
+    sylar::Mutex::Lock lock(m_mutex);
+    for(auto& i : ids) {
+        bumpLocked(i);
+    }
+}
+
+std::string ArticleRenderCache::statusString() {
+    std::stringstream ss;
+    sylar::Mutex::Lock lock(m_mutex);
+    ss << "ArticleRenderCache size=" << m_datas.size()
+       << " bytes=" << m_bytes
+       << " hits=" << m_hits
+       << " misses=" << m_misses
+       << std::endl;
+    lock.unlock();
+    return ss.str();
+}
+
+}
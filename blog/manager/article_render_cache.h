@@ -0,0 +1,62 @@
+#ifndef __BLOG_MANAGER_ARTICLE_RENDER_CACHE_H__
+#define __BLOG_MANAGER_ARTICLE_RENDER_CACHE_H__
+
+#include "blog/gzip.h"
+#include "sylar/mutex.h"
+#include <functional>
+#include <json/json.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blog {
+
+//snappy/detail响应中文章部分的预序列化片段
+//片段是去掉结尾'}'的json对象, 输出时用JsonWriter::openObject接上计数等易变字段
+class ArticleRenderCache {
+public:
+    enum Type {
+        SNAPPY = 0,
+        DETAIL = 1
+    };
+    //json较大时同时保存预压缩的gzip片段, 每个版本只压缩一次
+    struct Fragment {
+        typedef std::shared_ptr<const Fragment> ptr;
+        std::string json;
+        GzipPiece::ptr gzip;
+    };
+    typedef std::function<bool(Json::Value&)> Render;
+
+    ArticleRenderCache();
+
+    //render需在内部读取依赖的快照(如分类/标签关系索引), 渲染期间文章被bump则结果不缓存
+    bool get(Type type, int64_t id, Render render, Fragment::ptr& frag);
+    //文章更新/关系索引发布/审核/删除时调用
+    void bump(int64_t id);
+    void bump(const std::vector<int64_t>& ids);
+
+    std::string statusString();
+private:
+    struct Node {
+        Fragment::ptr frag;
+        std::list<uint64_t>::iterator pos;
+    };
+
+    void insert(uint64_t key, int64_t id, Fragment::ptr frag, uint64_t version);
+    void erase(uint64_t key);
+    void bumpLocked(int64_t id);
+private:
+    sylar::Mutex m_mutex;
+    std::unordered_map<uint64_t, Node> m_datas;
+    std::list<uint64_t> m_lru;
+    std::unordered_map<int64_t, uint64_t> m_versions;
+    uint64_t m_bytes;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+}
+
+#endif
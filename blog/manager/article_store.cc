@@ -0,0 +1,214 @@
+#include "article_store.h"
+#include "blog/util.h"
+#include <sstream>
+
+namespace blog {
+
+StringArena::Ref StringArena::add(const std::string& str) {
+    Ref ref;
+    ref.off = m_data.size();
+    ref.len = str.size();
+    m_data.append(str);
+    return ref;
+}
+
+std::string StringArena::get(const Ref& ref) const {
+    return m_data.substr(ref.off, ref.len);
+}
+
+bool StringArena::equals(const Ref& ref, const std::string& str) const {
+    return ref.len == str.size()
+        && m_data.compare(ref.off, ref.len, str) == 0;
+}
+
+ArticleView::ArticleView()
+    :id(0)
+    ,userId(0)
+    ,channel(0)
+    ,type(0)
+    ,state(0)
+    ,isDeleted(0)
+    ,publishTime(0)
+    ,views(0)
+    ,praise(0)
+    ,favorites(0)
+    ,updateTime(0) {
+}
+
+ArticleStore::ArticleStore()
+    :m_waste(0) {
+}
+
+void ArticleStore::reserve(size_t size) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_slots.reserve(size);
+#define XX(m) m.reserve(size);
+    XX(m_ids);
+    XX(m_userIds);
+    XX(m_channels);
+    XX(m_types);
+    XX(m_states);
+    XX(m_isDeleteds);
+    XX(m_publishTimes);
+    XX(m_views);
+    XX(m_praises);
+    XX(m_favorites);
+    XX(m_updateTimes);
+    XX(m_titles);
+    XX(m_summarys);
+#undef XX
+}
+
+void ArticleStore::set(data::ArticleInfo::ptr info) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    uint32_t slot = 0;
+    auto it = m_slots.find(info->getId());
+    if(it == m_slots.end()) {
+        slot = m_ids.size();
+        m_slots[info->getId()] = slot;
+        m_ids.push_back(info->getId());
+        m_userIds.push_back(0);
+        m_channels.push_back(0);
+        m_types.push_back(0);
+        m_states.push_back(0);
+        m_isDeleteds.push_back(0);
+        m_publishTimes.push_back(0);
+        m_views.push_back(0);
+        m_praises.push_back(0);
+        m_favorites.push_back(0);
+        m_updateTimes.push_back(0);
+        m_titles.push_back(m_strings.add(info->getTitle()));
+        m_summarys.push_back(StringArena::Ref());
+    } else {
+        slot = it->second;
+        if(!m_strings.equals(m_titles[slot], info->getTitle())) {
+            m_waste += m_titles[slot].len;
+            m_titles[slot] = m_strings.add(info->getTitle());
+        }
+    }
+    m_userIds[slot] = info->getUserId();
+    m_channels[slot] = info->getChannel();
+    m_types[slot] = info->getType();
+    m_states[slot] = info->getState();
+    m_isDeleteds[slot] = info->getIsDeleted();
+    m_publishTimes[slot] = info->getPublishTime();
+    m_views[slot] = info->getViews();
+    m_praises[slot] = info->getPraise();
+    m_favorites[slot] = info->getFavorites();
+    m_updateTimes[slot] = info->getUpdateTime();
+    checkCompact();
+}
+
+void ArticleStore::setSummary(int64_t id, const std::string& content) {
+    std::string summary = get_max_length_string(content, 100);
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    auto it = m_slots.find(id);
+    if(it == m_slots.end()) {
+        return;
+    }
+    uint32_t slot = it->second;
+    if(!m_strings.equals(m_summarys[slot], summary)) {
+        m_waste += m_summarys[slot].len;
+        m_summarys[slot] = m_strings.add(summary);
+    }
+    checkCompact();
+}
+
+void ArticleStore::checkCompact() {
+    if(m_waste > 1024 * 1024 && m_waste * 2 > m_strings.size()) {
+        compact();
+    }
+}
+
+void ArticleStore::compact() {
+    StringArena strings;
+    for(size_t i = 0; i < m_ids.size(); ++i) {
+        m_titles[i] = strings.add(m_strings.get(m_titles[i]));
+        m_summarys[i] = strings.add(m_strings.get(m_summarys[i]));
+    }
+    m_strings.swap(strings);
+    m_waste = 0;
+}
+
+void ArticleStore::fill(uint32_t slot, ArticleView& v, bool strings) const {
+    v.id = m_ids[slot];
+    v.userId = m_userIds[slot];
+    v.channel = m_channels[slot];
+    v.type = m_types[slot];
+    v.state = m_states[slot];
+    v.isDeleted = m_isDeleteds[slot];
+    v.publishTime = m_publishTimes[slot];
+    v.views = m_views[slot];
+    v.praise = m_praises[slot];
+    v.favorites = m_favorites[slot];
+    v.updateTime = m_updateTimes[slot];
+    if(strings) {
+        v.title = m_strings.get(m_titles[slot]);
+        v.summary = m_strings.get(m_summarys[slot]);
+    } else {
+        v.title.clear();
+        v.summary.clear();
+    }
+}
+
+bool ArticleStore::get(int64_t id, ArticleView& v, bool strings) {
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    auto it = m_slots.find(id);
+    if(it == m_slots.end()) {
+        return false;
+    }
+    fill(it->second, v, strings);
+    return true;
+}
+
+size_t ArticleStore::getMany(const std::vector<int64_t>& ids, std::vector<ArticleView>& vs
+                             ,bool strings) {
+    vs.resize(ids.size());
+    size_t count = 0;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    for(size_t i = 0; i < ids.size(); ++i) {
+        auto it = m_slots.find(ids[i]);
+        if(it == m_slots.end()) {
+            vs[i].id = 0;
+            continue;
+        }
+        fill(it->second, vs[i], strings);
+        ++count;
+    }
+    return count;
+}
+
+void ArticleStore::swap(ArticleStore& o) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    sylar::RWMutex::WriteLock lock2(o.m_mutex);
+    m_slots.swap(o.m_slots);
+#define XX(m) m.swap(o.m);
+    XX(m_ids);
+    XX(m_userIds);
+    XX(m_channels);
+    XX(m_types);
+    XX(m_states);
+    XX(m_isDeleteds);
+    XX(m_publishTimes);
+    XX(m_views);
+    XX(m_praises);
+    XX(m_favorites);
+    XX(m_updateTimes);
+    XX(m_titles);
+    XX(m_summarys);
+#undef XX
+    m_strings.swap(o.m_strings);
+    std::swap(m_waste, o.m_waste);
+}
+
+std::string ArticleStore::statusString() {
+    std::stringstream ss;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    ss << "ArticleStore rows=" << m_ids.size()
+       << " strings=" << m_strings.size()
+       << " waste=" << m_waste
+       << std::endl;
+    return ss.str();
+}
+
+}
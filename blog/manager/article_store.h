@@ -0,0 +1,92 @@
+#ifndef __BLOG_MANAGER_ARTICLE_STORE_H__
+#define __BLOG_MANAGER_ARTICLE_STORE_H__
+
+#include "blog/data/article_info.h"
+#include "sylar/mutex.h"
+#include <unordered_map>
+#include <vector>
+
+namespace blog {
+
+//只追加的字符串区, 用偏移+长度引用, 避免每个字符串单独分配
+class StringArena {
+public:
+    struct Ref {
+        Ref() :off(0), len(0) {}
+        uint32_t off;
+        uint32_t len;
+    };
+
+    Ref add(const std::string& str);
+    std::string get(const Ref& ref) const;
+    bool equals(const Ref& ref, const std::string& str) const;
+    void swap(StringArena& o) { m_data.swap(o.m_data); }
+    void clear() { m_data.clear(); }
+    size_t size() const { return m_data.size(); }
+private:
+    std::string m_data;
+};
+
+//文章读路径用的按值视图, 不持有shared_ptr
+struct ArticleView {
+    ArticleView();
+
+    int64_t id;
+    int64_t userId;
+    int64_t channel;
+    int32_t type;
+    int32_t state;
+    int32_t isDeleted;
+    int64_t publishTime;
+    int64_t views;
+    int64_t praise;
+    int64_t favorites;
+    int64_t updateTime;
+    std::string title;
+    std::string summary;
+};
+
+//文章热字段的列式存储, 标题和摘要放在StringArena中
+//是读路径上额外的一份拷贝, 不替代ArticleManager的m_datas
+class ArticleStore {
+public:
+    ArticleStore();
+
+    void set(data::ArticleInfo::ptr info);
+    void setSummary(int64_t id, const std::string& content);
+    bool get(int64_t id, ArticleView& v, bool strings = true);
+    //一次加锁批量读取, vs与ids一一对应, 不存在的id置0
+    //strings=false时不拷贝标题和摘要, 只需要数值字段的调用方不产生字符串分配
+    size_t getMany(const std::vector<int64_t>& ids, std::vector<ArticleView>& vs
+                   ,bool strings = true);
+
+    void reserve(size_t size);
+    void swap(ArticleStore& o);
+    std::string statusString();
+private:
+    void fill(uint32_t slot, ArticleView& v, bool strings) const;
+    void checkCompact();
+    void compact();
+private:
+    sylar::RWMutex m_mutex;
+    std::unordered_map<int64_t, uint32_t> m_slots;
+    std::vector<int64_t> m_ids;
+    std::vector<int64_t> m_userIds;
+    std::vector<int64_t> m_channels;
+    std::vector<int32_t> m_types;
+    std::vector<int32_t> m_states;
+    std::vector<int32_t> m_isDeleteds;
+    std::vector<int64_t> m_publishTimes;
+    std::vector<int64_t> m_views;
+    std::vector<int64_t> m_praises;
+    std::vector<int64_t> m_favorites;
+    std::vector<int64_t> m_updateTimes;
+    std::vector<StringArena::Ref> m_titles;
+    std::vector<StringArena::Ref> m_summarys;
+    StringArena m_strings;
+    size_t m_waste;
+};
+
+}
+
+#endif
@@ -2,34 +2,41 @@
 #include "sylar/log.h"
 #include "sylar/util.h"
 #include "blog/util.h"
+#include <algorithm>
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
+CategoryManager::CategoryManager() {
+}
+
 bool CategoryManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::CategoryInfo::ptr> results;
-    if(blog::data::CategoryInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "CategoryManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::CategoryInfo::ptr> datas;
     std::unordered_map<int64_t, std::map<std::string, blog::data::CategoryInfo::ptr> > users;
 
-    for(auto& i : results) {
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::CategoryInfoDao::QueryAll([&](data::CategoryInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
         users[i->getUserId()][i->getName()] = i;
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "CategoryManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "CategoryManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
     m_users.swap(users);
+    m_forest = nullptr;
     return true;
 }
 
@@ -37,6 +44,113 @@ void CategoryManager::add(blog::data::CategoryInfo::ptr info) {
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas[info->getId()] = info;
     m_users[info->getUserId()][info->getName()] = info;
+    m_forest = nullptr;
+    lock.unlock();
+    m_versions.bump(info->getId(), info->getUserId());
+}
+
+void CategoryManager::refresh(blog::data::CategoryInfo::ptr info) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_forest = nullptr;
+    lock.unlock();
+    m_versions.bump(info->getId(), info->getUserId());
+}
+
+bool CategoryManager::Forest::listSubtree(int64_t id, std::vector<int64_t>& ids) const {
+    auto it = ranges.find(id);
+    if(it == ranges.end()) {
+        return false;
+    }
+    ids.insert(ids.end(), order.begin() + it->second.first
+            ,order.begin() + it->second.second);
+    return true;
+}
+
+bool CategoryManager::Forest::isAncestor(int64_t ancestor, int64_t id) const {
+    auto a = ranges.find(ancestor);
+    auto b = ranges.find(id);
+    if(a == ranges.end() || b == ranges.end()) {
+        return false;
+    }
+    return a->second.first <= b->second.first
+        && b->second.second <= a->second.second;
+}
+
+CategoryManager::Forest::ptr CategoryManager::getForest() {
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    if(m_forest) {
+        return m_forest;
+    }
+    lock.unlock();
+
+    //只读内存不会切换协程, 持写锁构建, 并发的查询等待同一份结果
+    sylar::RWMutex::WriteLock lock2(m_mutex);
+    if(m_forest) {
+        return m_forest;
+    }
+    //父分类不存在时按根处理
+    std::vector<int64_t> roots;
+    std::unordered_map<int64_t, std::vector<int64_t> > children;
+    for(auto& i : m_datas) {
+        int64_t pid = i.second->getParentId();
+        if(pid && pid != i.first && m_datas.count(pid)) {
+            children[pid].push_back(i.first);
+        } else {
+            roots.push_back(i.first);
+        }
+    }
+    //成环的分类从任何根都不可达, 按id排序后依次补为根
+    std::vector<int64_t> all;
+    all.reserve(m_datas.size());
+    for(auto& i : m_datas) {
+        all.push_back(i.first);
+    }
+    std::sort(all.begin(), all.end());
+
+    std::shared_ptr<Forest> forest(new Forest);
+    forest->order.reserve(m_datas.size());
+    //second=false表示进入节点, true表示离开节点
+    std::vector<std::pair<int64_t, bool> > stack;
+    size_t n = 0;
+    size_t f = 0;
+    while(forest->order.size() < all.size()) {
+        int64_t root = 0;
+        if(n < roots.size()) {
+            root = roots[n++];
+        } else {
+            while(f < all.size() && forest->ranges.count(all[f])) {
+                ++f;
+            }
+            if(f == all.size()) {
+                break;
+            }
+            root = all[f];
+        }
+        stack.push_back(std::make_pair(root, false));
+        while(!stack.empty()) {
+            auto cur = stack.back();
+            stack.pop_back();
+            if(cur.second) {
+                forest->ranges[cur.first].second = forest->order.size();
+                continue;
+            }
+            if(forest->ranges.count(cur.first)) {
+                continue;
+            }
+            forest->ranges[cur.first] = std::make_pair(
+                    (uint32_t)forest->order.size(), (uint32_t)0);
+            forest->order.push_back(cur.first);
+            stack.push_back(std::make_pair(cur.first, true));
+            auto it = children.find(cur.first);
+            if(it != children.end()) {
+                for(auto& c : it->second) {
+                    stack.push_back(std::make_pair(c, false));
+                }
+            }
+        }
+    }
+    m_forest = forest;
+    return forest;
 }
 
 #define XX(map, key) \
@@ -92,7 +206,8 @@ std::string CategoryManager::statusString() {
     std::stringstream ss;
     sylar::RWMutex::ReadLock lock(m_mutex);
     ss << "CategoryManager total=" << m_datas.size()
-       << " users=" << m_users.size() << std::endl;
+       << " users=" << m_users.size()
+       << " forest=" << (m_forest ? m_forest->order.size() : 0) << std::endl;
     lock.unlock();
     return ss.str();
 }
@@ -4,13 +4,26 @@
 #include "blog/data/category_info.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
+#include "blog/manager/entity_version.h"
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 namespace blog {
 
 class CategoryManager {
 public:
+    //分类森林的欧拉序, 子树对应order中[tin, tout)连续区间
+    struct Forest {
+        typedef std::shared_ptr<const Forest> ptr;
+        std::vector<int64_t> order;
+        std::unordered_map<int64_t, std::pair<uint32_t, uint32_t> > ranges;
+
+        bool listSubtree(int64_t id, std::vector<int64_t>& ids) const;
+        bool isAncestor(int64_t ancestor, int64_t id) const;
+    };
+
+    CategoryManager();
     bool loadAll();
     void add(blog::data::CategoryInfo::ptr info);
     blog::data::CategoryInfo::ptr get(int64_t id);
@@ -18,11 +31,19 @@ public:
     blog::data::CategoryInfo::ptr getByUserIdName(int64_t id, const std::string& name);
     bool exists(int64_t id, const std::string& name);
 
+    Forest::ptr getForest();
+    //分类变更(parent_id/删除等)后调用, 更新版本号并使森林重建
+    void refresh(blog::data::CategoryInfo::ptr info);
+    uint64_t getVersion(int64_t id) { return m_versions.get(id); }
+    uint64_t getUserVersion(int64_t uid) { return m_versions.getGroup(uid); }
+
     std::string statusString();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::CategoryInfo::ptr> m_datas;
     std::unordered_map<int64_t, std::map<std::string, blog::data::CategoryInfo::ptr> > m_users;
+    Forest::ptr m_forest;
+    EntityVersion m_versions;
 };
 
 typedef sylar::Singleton<CategoryManager> CategoryMgr;
@@ -8,21 +8,24 @@ namespace blog {
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
 bool ChannelManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::ChannelInfo::ptr> results;
-    if(blog::data::ChannelInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "ChannelManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::ChannelInfo::ptr> datas;
-    for(auto& i : results) {
+
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::ChannelInfoDao::QueryAll([&](data::ChannelInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "ChannelManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "ChannelManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
@@ -32,6 +35,8 @@ bool ChannelManager::loadAll() {
 void ChannelManager::add(blog::data::ChannelInfo::ptr info) {
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas[info->getId()] = info;
+    lock.unlock();
+    m_versions.bump(info->getId());
 }
 
 #define XX(map, key) \
@@ -43,6 +48,22 @@ blog::data::ChannelInfo::ptr ChannelManager::get(int64_t id) {
     XX(m_datas, id);
 }
 
+size_t ChannelManager::getMany(const std::vector<int64_t>& ids, std::vector<blog::data::ChannelInfo::ptr>& infos) {
+    infos.resize(ids.size());
+    size_t count = 0;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    for(size_t i = 0; i < ids.size(); ++i) {
+        auto it = m_datas.find(ids[i]);
+        if(it == m_datas.end()) {
+            infos[i] = nullptr;
+            continue;
+        }
+        infos[i] = it->second;
+        ++count;
+    }
+    return count;
+}
+
 std::string ChannelManager::statusString() {
     std::stringstream ss;
     sylar::RWMutex::ReadLock lock(m_mutex);
@@ -4,6 +4,7 @@
 #include "blog/data/channel_info.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
+#include "blog/manager/entity_version.h"
 #include <map>
 #include <unordered_map>
 
@@ -14,11 +15,15 @@ public:
     bool loadAll();
     void add(blog::data::ChannelInfo::ptr info);
     blog::data::ChannelInfo::ptr get(int64_t id);
+    size_t getMany(const std::vector<int64_t>& ids, std::vector<blog::data::ChannelInfo::ptr>& infos);
     void listAll(std::map<int64_t, data::ChannelInfo::ptr>& infos);
+    uint64_t getVersion(int64_t id) { return m_versions.get(id); }
+    uint64_t getVersion() { return m_versions.current(); }
     std::string statusString();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::ChannelInfo::ptr> m_datas;
+    EntityVersion m_versions;
 };
 
 typedef sylar::Singleton<ChannelManager> ChannelMgr;
@@ -1,41 +1,59 @@
 #include "comment_manager.h"
 #include "sylar/log.h"
 #include "sylar/util.h"
+#include "sylar/config.h"
 #include "blog/util.h"
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+static sylar::ConfigVar<uint32_t>::ptr g_comment_thread_cache_size =
+    sylar::Config::Lookup("comment.thread_cache.max_size",
+            (uint32_t)10000, "comment thread cache max size");
+
+//没有已审核评论的文章共用, 不进缓存
+static CommentThread::ptr s_empty_thread(
+        new CommentThread(std::vector<data::CommentInfo::ptr>()));
+
+CommentManager::CommentManager()
+    :m_threadSeq(0) {
+}
 
 bool CommentManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::CommentInfo::ptr> results;
-    if(blog::data::CommentInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "CommentManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::CommentInfo::ptr> datas;
     std::map<int64_t, blog::data::CommentInfo::ptr> verifys;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::CommentInfo::ptr> > articles;
 
-    for(auto& i : results) {
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::CommentInfoDao::QueryAll([&](data::CommentInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
         articles[i->getArticleId()][i->getId()] = i;
         if(i->getState() == 1
                 && i->getIsDeleted() == 0) {
             verifys[i->getId()] = i;
         }
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "CommentManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "CommentManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
     m_articles.swap(articles);
     m_verifys.swap(verifys);
+    sylar::Mutex::Lock lock2(m_threadMutex);
+    m_threads.clear();
+    m_threadLru.clear();
+    ++m_threadSeq;
     return true;
 }
 
@@ -47,6 +65,69 @@ void CommentManager::add(blog::data::CommentInfo::ptr info) {
             && info->getIsDeleted() == 0) {
         m_verifys[info->getId()] = info;
     }
+    sylar::Mutex::Lock lock2(m_threadMutex);
+    eraseThread(info->getArticleId());
+    ++m_threadSeq;
+}
+
+void CommentManager::refresh(blog::data::CommentInfo::ptr info) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    sylar::Mutex::Lock lock2(m_threadMutex);
+    eraseThread(info->getArticleId());
+    ++m_threadSeq;
+}
+
+void CommentManager::eraseThread(int64_t article_id) {
+    auto it = m_threads.find(article_id);
+    if(it != m_threads.end()) {
+        m_threadLru.erase(it->second.pos);
+        m_threads.erase(it);
+    }
+}
+
+CommentThread::ptr CommentManager::getThread(int64_t article_id) {
+    sylar::Mutex::Lock tlock(m_threadMutex);
+    auto it = m_threads.find(article_id);
+    if(it != m_threads.end()) {
+        m_threadLru.splice(m_threadLru.begin(), m_threadLru, it->second.pos);
+        return it->second.thread;
+    }
+    //先取seq再读评论, 读取后发生的变更会使seq变化
+    uint64_t seq = m_threadSeq;
+    tlock.unlock();
+
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    std::vector<data::CommentInfo::ptr> infos;
+    auto uit = m_articles.find(article_id);
+    if(uit != m_articles.end()) {
+        for(auto& i : uit->second) {
+            if(!i.second->getIsDeleted() && i.second->getState() == 2) {
+                infos.push_back(i.second);
+            }
+        }
+    }
+    lock.unlock();
+    //不存在或没有可见评论的文章不缓存, 避免任意id撑大m_threads
+    if(infos.empty()) {
+        return s_empty_thread;
+    }
+
+    CommentThread::ptr thread(new CommentThread(infos));
+    tlock.lock();
+    //构建期间有评论变更, 结果可能已过期, 不缓存
+    if(seq != m_threadSeq || m_threads.count(article_id)) {
+        return thread;
+    }
+    m_threadLru.push_front(article_id);
+    ThreadNode& node = m_threads[article_id];
+    node.thread = thread;
+    node.pos = m_threadLru.begin();
+    while(m_threads.size() > g_comment_thread_cache_size->getValue()
+            && m_threadLru.size() > 1) {
+        m_threads.erase(m_threadLru.back());
+        m_threadLru.pop_back();
+    }
+    return thread;
 }
 
 #define XX(map, key) \
@@ -121,9 +202,12 @@ std::string CommentManager::statusString() {
     sylar::RWMutex::ReadLock lock(m_mutex);
     ss << "CommentManager total=" << m_datas.size()
        << " articles=" << m_articles.size()
-       << " verifys=" << m_verifys.size()
-       << std::endl;
+       << " verifys=" << m_verifys.size();
     lock.unlock();
+    sylar::Mutex::Lock lock2(m_threadMutex);
+    ss << " threads=" << m_threads.size()
+       << std::endl;
+    lock2.unlock();
     return ss.str();
 }
 
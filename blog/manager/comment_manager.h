@@ -2,19 +2,25 @@
 #define __BLOG_MANAGER_COMMENT_MANAGER_H__
 
 #include "blog/data/comment_info.h"
+#include "blog/manager/comment_thread.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
 #include <unordered_map>
+#include <list>
 
 namespace blog {
 
 class CommentManager {
 public:
+    CommentManager();
     bool loadAll();
     void add(blog::data::CommentInfo::ptr info);
     blog::data::CommentInfo::ptr get(int64_t id);
     int64_t listByArticleId(std::vector<blog::data::CommentInfo::ptr>& infos,
             int64_t article_id, int64_t offset, int64_t size, bool valid);
+    //没有已审核评论时返回共享的空thread, 不缓存; 缓存按数量LRU淘汰
+    CommentThread::ptr getThread(int64_t article_id);
+    void refresh(blog::data::CommentInfo::ptr info);
 
     void delVerify(int64_t id);
     void addVerify(data::CommentInfo::ptr info);
@@ -23,11 +29,23 @@ public:
                             ,int32_t offset, int32_t size);
 
     std::string statusString();
+private:
+    //调用方持有m_threadMutex
+    void eraseThread(int64_t article_id);
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::CommentInfo::ptr> m_datas;
     std::unordered_map<int64_t, std::map<int64_t, blog::data::CommentInfo::ptr> > m_articles;
     std::map<int64_t, blog::data::CommentInfo::ptr> m_verifys;
+    //m_threads/m_threadLru/m_threadSeq由m_threadMutex保护, 命中时调整LRU不需要写锁
+    struct ThreadNode {
+        CommentThread::ptr thread;
+        std::list<int64_t>::iterator pos;
+    };
+    sylar::Mutex m_threadMutex;
+    std::unordered_map<int64_t, ThreadNode> m_threads;
+    std::list<int64_t> m_threadLru;
+    uint64_t m_threadSeq;
 };
 
 typedef sylar::Singleton<CommentManager> CommentMgr;
@@ -0,0 +1,129 @@
+#include "comment_thread.h"
+#include "blog/json_writer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace blog {
+
+static const size_t s_max_pages = 32;
+
+CommentThread::CommentThread(const std::vector<data::CommentInfo::ptr>& infos) {
+    std::unordered_map<int64_t, data::CommentInfo::ptr> datas;
+    for(auto& i : infos) {
+        datas[i->getId()] = i;
+        m_flat.push_back(i->getId());
+    }
+    std::sort(m_flat.begin(), m_flat.end(), std::greater<int64_t>());
+
+    //父评论不可见时按顶层处理, 成环的评论在下面补挂到顶层
+    std::vector<int64_t> roots;
+    std::unordered_map<int64_t, std::vector<int64_t> > children;
+    for(auto& i : m_flat) {
+        auto& info = datas[i];
+        int64_t pid = info->getParentId();
+        if(pid && pid != i && datas.count(pid)) {
+            children[pid].push_back(i);
+        } else {
+            roots.push_back(i);
+        }
+    }
+
+    m_tree.reserve(m_flat.size());
+    std::unordered_set<int64_t> visited;
+    std::vector<std::pair<int64_t, int32_t> > stack;
+    size_t n = 0;
+    size_t f = 0;
+    while(m_tree.size() < m_flat.size()) {
+        int64_t root = 0;
+        if(n < roots.size()) {
+            root = roots[n++];
+        } else {
+            //环上的评论从任何顶层都不可达, 取剩下id最大的一条作为顶层
+            while(f < m_flat.size() && visited.count(m_flat[f])) {
+                ++f;
+            }
+            if(f == m_flat.size()) {
+                break;
+            }
+            root = m_flat[f];
+        }
+        stack.push_back(std::make_pair(root, 0));
+        while(!stack.empty()) {
+            auto cur = stack.back();
+            stack.pop_back();
+            if(!visited.insert(cur.first).second) {
+                continue;
+            }
+            Node node;
+            node.id = cur.first;
+            node.parentId = cur.second ? datas[cur.first]->getParentId() : 0;
+            node.depth = cur.second;
+            node.replys = 0;
+            auto it = children.find(cur.first);
+            if(it != children.end()) {
+                node.replys = it->second.size();
+                //children按id倒序存放, 依次压栈后按id正序弹出
+                for(auto& c : it->second) {
+                    stack.push_back(std::make_pair(c, cur.second + 1));
+                }
+            }
+            m_tree.push_back(node);
+        }
+    }
+}
+
+void CommentThread::render(std::string& page, int64_t offset, int64_t size, bool tree) {
+    int64_t total = tree ? m_tree.size() : m_flat.size();
+    //offset/size来自请求参数, 先夹到[0, total]再算区间, 避免相加溢出
+    int64_t begin = std::min(std::max(offset, (int64_t)0), total);
+    int64_t end = begin + std::min(std::max(size, (int64_t)0), total - begin);
+
+    JsonWriter w(page);
+    w.startObject();
+    w.set("total", (uint64_t)m_flat.size());
+    w.key("ids");
+    w.startArray();
+    for(int64_t i = begin; i < end; ++i) {
+        w.append(tree ? m_tree[i].id : m_flat[i]);
+    }
+    w.endArray();
+    if(tree) {
+        w.key("nodes");
+        w.startArray();
+        for(int64_t i = begin; i < end; ++i) {
+            auto& node = m_tree[i];
+            w.startObject();
+            w.set("id", node.id);
+            w.set("parent_id", node.parentId);
+            w.set("depth", node.depth);
+            w.set("reply_count", node.replys);
+            w.endObject();
+        }
+        w.endArray();
+    }
+    w.endObject();
+    page.resize(page.size() - 1);
+}
+
+CommentThread::Page CommentThread::getPage(int64_t offset, int64_t size, bool tree) {
+    auto key = std::make_tuple(tree, offset, size);
+    sylar::Mutex::Lock lock(m_mutex);
+    auto it = m_pages.find(key);
+    if(it != m_pages.end()) {
+        return it->second;
+    }
+    lock.unlock();
+
+    std::shared_ptr<std::string> page(new std::string);
+    render(*page, offset, size, tree);
+
+    lock.lock();
+    if(m_pages.size() >= s_max_pages) {
+        m_pages.clear();
+    }
+    m_pages[key] = page;
+    return page;
+}
+
+}
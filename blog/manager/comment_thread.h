@@ -0,0 +1,41 @@
+#ifndef __BLOG_MANAGER_COMMENT_THREAD_H__
+#define __BLOG_MANAGER_COMMENT_THREAD_H__
+
+#include "blog/data/comment_info.h"
+#include "sylar/mutex.h"
+#include <map>
+#include <tuple>
+
+namespace blog {
+
+//单篇文章已审核评论的回复树, 构建后只读, 分页结果按需缓存
+//缓存的分页是去掉结尾'}'的json片段, 输出时用JsonWriter::openObject接上分页参数
+class CommentThread {
+public:
+    typedef std::shared_ptr<CommentThread> ptr;
+    typedef std::shared_ptr<const std::string> Page;
+
+    struct Node {
+        int64_t id;
+        int64_t parentId;
+        int32_t depth;
+        int32_t replys;
+    };
+
+    CommentThread(const std::vector<data::CommentInfo::ptr>& infos);
+
+    //tree=false按id倒序平铺, tree=true按楼层先序展开
+    Page getPage(int64_t offset, int64_t size, bool tree);
+    size_t size() const { return m_flat.size(); }
+private:
+    void render(std::string& page, int64_t offset, int64_t size, bool tree);
+private:
+    std::vector<int64_t> m_flat;
+    std::vector<Node> m_tree;
+    sylar::Mutex m_mutex;
+    std::map<std::tuple<bool, int64_t, int64_t>, Page> m_pages;
+};
+
+}
+
+#endif
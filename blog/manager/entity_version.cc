@@ -0,0 +1,46 @@
+#include "entity_version.h"
+#include "sylar/util.h"
+
+namespace blog {
+
+EntityVersion::EntityVersion()
+    :m_base(sylar::GetCurrentUS())
+    ,m_seq(m_base) {
+}
+
+uint64_t EntityVersion::next() {
+    uint64_t now = sylar::GetCurrentUS();
+    m_seq = now > m_seq ? now : m_seq + 1;
+    return m_seq;
+}
+
+void EntityVersion::bump(int64_t id, int64_t group) {
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    uint64_t v = next();
+    m_ids[id] = v;
+    if(group) {
+        m_groups[group] = v;
+    }
+}
+
+#define XX(map, key) \
+    sylar::RWMutex::ReadLock lock(m_mutex); \
+    auto it = map.find(key); \
+    return it == map.end() ? m_base : it->second;
+
+uint64_t EntityVersion::get(int64_t id) {
+    XX(m_ids, id);
+}
+
+uint64_t EntityVersion::getGroup(int64_t group) {
+    XX(m_groups, group);
+}
+
+#undef XX
+
+uint64_t EntityVersion::current() {
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    return m_seq;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef __BLOG_MANAGER_ENTITY_VERSION_H__
+#define __BLOG_MANAGER_ENTITY_VERSION_H__
+
+#include "sylar/mutex.h"
+#include <unordered_map>
+
+namespace blog {
+
+//实体版本号, 用于生成ETag/Last-Modified
+//版本取单调递增的微秒时间戳, 进程重启后也不会回退, 未变更过的实体取启动时间
+class EntityVersion {
+public:
+    EntityVersion();
+
+    //group为实体所属分组(如user_id), 0表示不分组
+    void bump(int64_t id, int64_t group = 0);
+    uint64_t get(int64_t id);
+    uint64_t getGroup(int64_t group);
+    uint64_t current();
+
+    static time_t ToTime(uint64_t v) { return v / 1000000; }
+private:
+    uint64_t next();
+private:
+    sylar::RWMutex m_mutex;
+    uint64_t m_base;
+    uint64_t m_seq;
+    std::unordered_map<int64_t, uint64_t> m_ids;
+    std::unordered_map<int64_t, uint64_t> m_groups;
+};
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "interact_cache.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include "sylar/config.h"
+#include "sylar/db/redis.h"
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+static sylar::ConfigVar<uint32_t>::ptr g_interact_cache_max_size =
+    sylar::Config::Lookup("article.interact_cache.max_size",
+            (uint32_t)10000, "article interact cache max size");
+static sylar::ConfigVar<uint32_t>::ptr g_interact_cache_ttl =
+    sylar::Config::Lookup("article.interact_cache.ttl",
+            (uint32_t)300, "article interact cache ttl second");
+
+static const char* s_hgetall_masks[] = {
+    "hgetall pra_a2u:%lld",
+    "hgetall pra_u2a:%lld",
+    "hgetall fav_a2u:%lld",
+    "hgetall fav_u2a:%lld"
+};
+
+InteractCache::InteractCache()
+    :m_writeSeq(0)
+    ,m_hits(0)
+    ,m_misses(0) {
+}
+
+uint64_t InteractCache::MakeKey(Type type, int64_t id) {
+    return ((uint64_t)id << 2) | (uint64_t)type;
+}
+
+InteractCache::Node* InteractCache::lookup(uint64_t key, uint64_t now) {
+    auto it = m_datas.find(key);
+    if(it == m_datas.end()) {
+        return nullptr;
+    }
+    if(now - it->second.loadTime >= g_interact_cache_ttl->getValue() * 1000ul) {
+        m_lru.erase(it->second.pos);
+        m_datas.erase(it);
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second.pos);
+    return &it->second;
+}
+
+bool InteractCache::load(Type type, int64_t id, Set& vals) {
+    auto rpy = sylar::RedisUtil::Cmd("blog", s_hgetall_masks[type], id);
+    if(!rpy) {
+        SYLAR_LOG_ERROR(g_logger) << "hgetall fail type=" << type << " id=" << id;
+        return false;
+    }
+    for(size_t i = 0; i + 1 < rpy->elements; i += 2) {
+        vals[sylar::TypeUtil::Atoi(rpy->element[i]->str)]
+            = sylar::TypeUtil::Atoi(rpy->element[i + 1]->str);
+    }
+    return true;
+}
+
+void InteractCache::insert(uint64_t key, const Set& vals, uint64_t seq) {
+    sylar::Mutex::Lock lock(m_mutex);
+    //加载期间有写入, 加载结果可能已过期, 不缓存
+    if(seq != m_writeSeq) {
+        return;
+    }
+    auto it = m_datas.find(key);
+    if(it != m_datas.end()) {
+        return;
+    }
+    m_lru.push_front(key);
+    Node& node = m_datas[key];
+    node.vals = vals;
+    node.loadTime = sylar::GetCurrentMS();
+    node.pos = m_lru.begin();
+    while(m_datas.size() > g_interact_cache_max_size->getValue()) {
+        m_datas.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+}
+
+bool InteractCache::get(Type type, int64_t id, Set& vals) {
+    uint64_t key = MakeKey(type, id);
+    sylar::Mutex::Lock lock(m_mutex);
+    Node* node = lookup(key, sylar::GetCurrentMS());
+    if(node) {
+        ++m_hits;
+        vals = node->vals;
+        return true;
+    }
+    ++m_misses;
+    uint64_t seq = m_writeSeq;
+    lock.unlock();
+
+    if(!load(type, id, vals)) {
+        return false;
+    }
+    insert(key, vals, seq);
+    return true;
+}
+
+bool InteractCache::exists(Type type, int64_t id, int64_t member, bool& exists) {
+    uint64_t key = MakeKey(type, id);
+    sylar::Mutex::Lock lock(m_mutex);
+    Node* node = lookup(key, sylar::GetCurrentMS());
+    if(node) {
+        ++m_hits;
+        exists = node->vals.count(member) > 0;
+        return true;
+    }
+    lock.unlock();
+
+    Set vals;
+    if(!get(type, id, vals)) {
+        return false;
+    }
+    exists = vals.count(member) > 0;
+    return true;
+}
+
+void InteractCache::add(Type type, int64_t id, int64_t member, int64_t ts) {
+    sylar::Mutex::Lock lock(m_mutex);
+    ++m_writeSeq;
+    auto it = m_datas.find(MakeKey(type, id));
+    if(it != m_datas.end()) {
+        it->second.vals[member] = ts;
+    }
+}
+
+void InteractCache::del(Type type, int64_t id, int64_t member) {
+    sylar::Mutex::Lock lock(m_mutex);
+    ++m_writeSeq;
+    auto it = m_datas.find(MakeKey(type, id));
+    if(it != m_datas.end()) {
+        it->second.vals.erase(member);
+    }
+}
+
+void InteractCache::invalidate(Type type, int64_t id) {
+    sylar::Mutex::Lock lock(m_mutex);
+    ++m_writeSeq;
+    auto it = m_datas.find(MakeKey(type, id));
+    if(it != m_datas.end()) {
+        m_lru.erase(it->second.pos);
+        m_datas.erase(it);
+    }
+}
+
+std::string InteractCache::statusString() {
+    std::stringstream ss;
+    sylar::Mutex::Lock lock(m_mutex);
+    ss << "InteractCache size=" << m_datas.size()
+       << " hits=" << m_hits
+       << " misses=" << m_misses
+       << std::endl;
+    lock.unlock();
+    return ss.str();
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef __BLOG_MANAGER_INTERACT_CACHE_H__
+#define __BLOG_MANAGER_INTERACT_CACHE_H__
+
+#include "sylar/mutex.h"
+#include <list>
+#include <map>
+#include <unordered_map>
+
+namespace blog {
+
+//缓存redis中 pra_a2u/pra_u2a/fav_a2u/fav_u2a 的hash, TTL+LRU淘汰, inc/dec写穿透
+class InteractCache {
+public:
+    enum Type {
+        PRA_A2U = 0,
+        PRA_U2A = 1,
+        FAV_A2U = 2,
+        FAV_U2A = 3
+    };
+    typedef std::map<int64_t, int64_t> Set;
+
+    InteractCache();
+
+    bool get(Type type, int64_t id, Set& vals);
+    bool exists(Type type, int64_t id, int64_t member, bool& exists);
+
+    void add(Type type, int64_t id, int64_t member, int64_t ts);
+    void del(Type type, int64_t id, int64_t member);
+    //redis写入结果未知时丢弃整组, 下次从redis重新加载
+    void invalidate(Type type, int64_t id);
+
+    std::string statusString();
+private:
+    struct Node {
+        Set vals;
+        uint64_t loadTime;
+        std::list<uint64_t>::iterator pos;
+    };
+
+    static uint64_t MakeKey(Type type, int64_t id);
+    Node* lookup(uint64_t key, uint64_t now);
+    bool load(Type type, int64_t id, Set& vals);
+    void insert(uint64_t key, const Set& vals, uint64_t seq);
+private:
+    sylar::Mutex m_mutex;
+    std::unordered_map<uint64_t, Node> m_datas;
+    std::list<uint64_t> m_lru;
+    uint64_t m_writeSeq;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+}
+
+#endif
@@ -8,24 +8,26 @@ namespace blog {
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
 bool LabelManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::LabelInfo::ptr> results;
-    if(blog::data::LabelInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "LabelManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::LabelInfo::ptr> datas;
     std::unordered_map<int64_t, std::map<std::string, blog::data::LabelInfo::ptr> > users;
 
-    for(auto& i : results) {
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::LabelInfoDao::QueryAll([&](data::LabelInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
         users[i->getUserId()][i->getName()] = i;
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "LabelManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "LabelManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
@@ -37,6 +39,12 @@ void LabelManager::add(blog::data::LabelInfo::ptr info) {
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas[info->getId()] = info;
     m_users[info->getUserId()][info->getName()] = info;
+    lock.unlock();
+    m_versions.bump(info->getId(), info->getUserId());
+}
+
+void LabelManager::refresh(blog::data::LabelInfo::ptr info) {
+    m_versions.bump(info->getId(), info->getUserId());
 }
 
 #define XX(map, key) \
@@ -4,6 +4,7 @@
 #include "blog/data/label_info.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
+#include "blog/manager/entity_version.h"
 #include <map>
 #include <unordered_map>
 
@@ -17,11 +18,17 @@ public:
     blog::data::LabelInfo::ptr getByUserIdName(int64_t id, const std::string& name);
     bool listByUserId(std::vector<data::LabelInfo::ptr>& infos, int64_t id, bool valid);
 
+    //标签变更后调用, 更新版本号
+    void refresh(blog::data::LabelInfo::ptr info);
+    uint64_t getVersion(int64_t id) { return m_versions.get(id); }
+    uint64_t getUserVersion(int64_t uid) { return m_versions.getGroup(uid); }
+
     std::string statusString();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::LabelInfo::ptr> m_datas;
     std::unordered_map<int64_t, std::map<std::string, blog::data::LabelInfo::ptr> > m_users;
+    EntityVersion m_versions;
 };
 
 typedef sylar::Singleton<LabelManager> LabelMgr;
@@ -2,40 +2,81 @@
 #include "sylar/log.h"
 #include "sylar/util.h"
 #include "blog/util.h"
+#include "sylar/config.h"
+#include "blog/change_log.h"
+#include <openssl/crypto.h>
+#include <openssl/hmac.h>
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 
+static sylar::ConfigVar<std::string>::ptr g_token_secret =
+    sylar::Config::Lookup("session.token_secret", std::string(""), "session sign token hmac secret, required");
+
+static const size_t s_min_token_secret = 32;
+
+static sylar::ConfigVar<uint32_t>::ptr g_last_seen_interval =
+    sylar::Config::Lookup("user.last_seen.flush_interval", (uint32_t)5000, "user login time flush interval ms");
+
+static std::string TokenSign(const std::string& payload) {
+    auto secret = g_token_secret->getValue();
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), secret.c_str(), secret.size()
+            ,(const unsigned char*)payload.c_str(), payload.size(), md, &len);
+    static const char s_hex[] = "0123456789abcdef";
+    std::string rt;
+    //截取前128位
+    for(unsigned int i = 0; i < len && i < 16; ++i) {
+        rt.push_back(s_hex[md[i] >> 4]);
+        rt.push_back(s_hex[md[i] & 0xF]);
+    }
+    return rt;
+}
+
+//密码哈希的HMAC取前64位, 改密码后旧令牌失效, 令牌中也不暴露密码哈希的信息
+static std::string TokenSalt(data::UserInfo::ptr info) {
+    return TokenSign("passwd|" + info->getPasswd()).substr(0, 16);
+}
+
+UserManager::UserManager()
+    :m_seenTouches(0)
+    ,m_seenRows(0) {
+}
+
 bool UserManager::loadAll() {
-    auto db = GetDB();
+    auto db = GetReadDB();
     if(!db) {
         SYLAR_LOG_ERROR(g_logger) << "Get SQLite3 connection fail";
         return false;
     }
-    std::vector<data::UserInfo::ptr> results;
-    if(blog::data::UserInfoDao::QueryAll(results, db)) {
-        SYLAR_LOG_ERROR(g_logger) << "UserManager loadAll fail";
-        return false;
-    }
-
     std::unordered_map<int64_t, blog::data::UserInfo::ptr> datas;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> accounts;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> emails;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> names;
 
-    for(auto& i : results) {
+    uint64_t ts = sylar::GetCurrentMS();
+    size_t rows = 0;
+    if(blog::data::UserInfoDao::QueryAll([&](data::UserInfo::ptr i) {
+        ++rows;
         datas[i->getId()] = i;
         accounts[i->getAccount()] = i;
         emails[i->getEmail()] = i;
         names[i->getName()] = i;
+    }, db)) {
+        SYLAR_LOG_ERROR(g_logger) << "UserManager loadAll fail";
+        return false;
     }
+    SYLAR_LOG_INFO(g_logger) << "UserManager loadAll rows=" << rows
+        << " used=" << (sylar::GetCurrentMS() - ts) << "ms";
 
     sylar::RWMutex::WriteLock lock(m_mutex);
     m_datas.swap(datas);
     m_accounts.swap(accounts);
     m_emails.swap(emails);
     m_names.swap(names);
+    lock.unlock();
     return true;
 }
 
@@ -56,6 +97,22 @@ blog::data::UserInfo::ptr UserManager::get(int64_t id) {
     XX(m_datas, id);
 }
 
+size_t UserManager::getMany(const std::vector<int64_t>& ids, std::vector<blog::data::UserInfo::ptr>& infos) {
+    infos.resize(ids.size());
+    size_t count = 0;
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    for(size_t i = 0; i < ids.size(); ++i) {
+        auto it = m_datas.find(ids[i]);
+        if(it == m_datas.end()) {
+            infos[i] = nullptr;
+            continue;
+        }
+        infos[i] = it->second;
+        ++count;
+    }
+    return count;
+}
+
 blog::data::UserInfo::ptr UserManager::getByAccount(const std::string& v) {
     XX(m_accounts, v);
 }
@@ -80,12 +137,112 @@ std::string UserManager::GetToken(data::UserInfo::ptr info, int64_t ts) {
     return sylar::md5(ss.str());
 }
 
+bool UserManager::CheckTokenSecret() {
+    if(g_token_secret->getValue().size() < s_min_token_secret) {
+        SYLAR_LOG_ERROR(g_logger) << "session.token_secret must be set to at least "
+            << s_min_token_secret << " bytes of random data";
+        return false;
+    }
+    return true;
+}
+
+std::string UserManager::GetSignToken(data::UserInfo::ptr info, int64_t expire) {
+    std::string payload = std::to_string(info->getId())
+        + "." + std::to_string(expire)
+        + "." + TokenSalt(info);
+    return payload + "." + TokenSign(payload);
+}
+
+int64_t UserManager::VerifySignToken(const std::string& token) {
+    auto pos = token.rfind('.');
+    if(pos == std::string::npos) {
+        return 0;
+    }
+    auto parts = sylar::split(token.substr(0, pos), '.');
+    if(parts.size() != 3) {
+        return 0;
+    }
+    int64_t uid = sylar::TypeUtil::Atoi(parts[0]);
+    int64_t expire = sylar::TypeUtil::Atoi(parts[1]);
+    if(!uid || expire <= time(0)) {
+        return 0;
+    }
+    auto sign = TokenSign(token.substr(0, pos));
+    if(sign.size() != token.size() - pos - 1
+            || CRYPTO_memcmp(sign.c_str(), token.c_str() + pos + 1, sign.size())) {
+        return 0;
+    }
+    //签名正确后仍查一次内存中的用户(不访问数据库), 是有意为之:
+    //封禁和改密码要让已签发的令牌立即失效, 令牌本身无法撤销
+    auto info = UserMgr::GetInstance()->get(uid);
+    if(!info || info->getState() != 2 || TokenSalt(info) != parts[2]) {
+        return 0;
+    }
+    return uid;
+}
+
+void UserManager::touchLogin(data::UserInfo::ptr info, int64_t ts) {
+    info->setLoginTime(ts);
+    sylar::Mutex::Lock lock(m_seenMutex);
+    ++m_seenTouches;
+    m_seens[info->getId()] = info;
+}
+
+void UserManager::flushLastSeen() {
+    sylar::Mutex::Lock lock(m_seenMutex);
+    if(m_seens.empty()) {
+        return;
+    }
+    std::vector<data::UserInfo::ptr> infos;
+    infos.reserve(m_seens.size());
+    for(auto& i : m_seens) {
+        infos.push_back(i.second);
+    }
+    m_seens.clear();
+    m_seenRows += infos.size();
+    lock.unlock();
+
+    if(ChangeLogMgr::GetInstance()->update(infos)) {
+        SYLAR_LOG_ERROR(g_logger) << "flush user login time fail size=" << infos.size();
+        //失败的放回去下次重试, 期间有新记录的以新的为准
+        lock.lock();
+        for(auto& i : infos) {
+            m_seens.insert(std::make_pair(i->getId(), i));
+        }
+    }
+}
+
+void UserManager::start() {
+    sylar::Mutex::Lock lock(m_seenMutex);
+    if(m_seenTimer) {
+        return;
+    }
+    m_seenTimer = sylar::IOManager::GetThis()->addTimer(g_last_seen_interval->getValue(),
+                std::bind(&UserManager::flushLastSeen, this), true);
+}
+
+void UserManager::stop() {
+    sylar::Mutex::Lock lock(m_seenMutex);
+    if(!m_seenTimer) {
+        return;
+    }
+    m_seenTimer->cancel();
+    m_seenTimer = nullptr;
+    lock.unlock();
+    flushLastSeen();
+}
+
 std::string UserManager::statusString() {
     std::stringstream ss;
     sylar::RWMutex::ReadLock lock(m_mutex);
     ss << "UserManager total=" << m_datas.size()
        << std::endl;
     lock.unlock();
+    sylar::Mutex::Lock lock2(m_seenMutex);
+    ss << "    last_seen pending=" << m_seens.size()
+       << " touches=" << m_seenTouches
+       << " rows=" << m_seenRows
+       << std::endl;
     return ss.str();
 }
 
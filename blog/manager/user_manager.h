@@ -4,6 +4,7 @@
 #include "blog/data/user_info.h"
 #include "sylar/singleton.h"
 #include "sylar/mutex.h"
+#include "sylar/iomanager.h"
 #include <unordered_map>
 
 namespace blog {
@@ -14,22 +15,43 @@ public:
         NORMAL = 1,
         ADMIN = 0xFF
     };
+    UserManager();
     bool loadAll();
     void add(blog::data::UserInfo::ptr info);
     blog::data::UserInfo::ptr get(int64_t id);
+    size_t getMany(const std::vector<int64_t>& ids, std::vector<blog::data::UserInfo::ptr>& infos);
     blog::data::UserInfo::ptr getByAccount(const std::string& v);
     blog::data::UserInfo::ptr getByEmail(const std::string& v);
     blog::data::UserInfo::ptr getByName(const std::string& v);
 
     static std::string GetToken(data::UserInfo::ptr info, int64_t ts);
+    //session.token_secret未配置或过短返回false, 启动时检查, 不通过则服务不启动
+    static bool CheckTokenSecret();
+    //HMAC签名的登录令牌 uid.expire.salt.sign, salt取自密码, 改密码后旧令牌失效
+    static std::string GetSignToken(data::UserInfo::ptr info, int64_t expire);
+    //校验通过返回uid, 否则返回0; 会查UserMgr确认账号状态和密码未变
+    static int64_t VerifySignToken(const std::string& token);
+
+    //记录登录时间, 内存立即生效, 同一用户定时合并后批量写入, 请求不等待写库
+    void touchLogin(data::UserInfo::ptr info, int64_t ts);
 
     std::string statusString();
+    void start();
+    void stop();
+private:
+    void flushLastSeen();
 private:
     sylar::RWMutex m_mutex;
     std::unordered_map<int64_t, blog::data::UserInfo::ptr> m_datas;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> m_accounts;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> m_emails;
     std::unordered_map<std::string, blog::data::UserInfo::ptr> m_names;
+
+    sylar::Mutex m_seenMutex;
+    std::unordered_map<int64_t, blog::data::UserInfo::ptr> m_seens;
+    sylar::Timer::ptr m_seenTimer;
+    uint64_t m_seenTouches;
+    uint64_t m_seenRows;
 };
 
 typedef sylar::Singleton<UserManager> UserMgr;
@@ -3,6 +3,7 @@
 #include "sylar/log.h"
 #include "blog/data/user_info.h"
 #include "sylar/application.h"
+#include "sylar/worker.h"
 #include "blog/index.h"
 #include "blog/word_parser.h"
 #include "blog/servlets/article_create_servlet.h"
@@ -53,6 +54,11 @@
 #include "blog/manager/label_manager.h"
 #include "blog/manager/user_manager.h"
 #include "blog/util.h"
+#include "blog/change_log.h"
+#include "blog/passwd_hasher.h"
+#include "blog/rate_limiter.h"
+#include "blog/db_pool.h"
+#include "blog/consistency_checker.h"
 
 namespace blog {
 
@@ -60,6 +66,9 @@ static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
 static sylar::ConfigVar<std::string>::ptr g_sqlite3_db_name =
     sylar::Config::Lookup("sqlite3.db_name",
             std::string("blog.db"), "sqlite3 db file name");
+static sylar::ConfigVar<std::string>::ptr g_change_log_path =
+    sylar::Config::Lookup("change_log.path",
+            std::string("change.log"), "change log file name, empty to disable");
 
 MyModule::MyModule()
     :sylar::Module("sblog", "1.0", "") {
@@ -72,6 +81,11 @@ bool MyModule::onLoad() {
 
 bool MyModule::onUnload() {
     SYLAR_LOG_INFO(g_logger) << "onUnload";
+    UserMgr::GetInstance()->stop();
+    RateLimiterMgr::GetInstance()->stop();
+    ConsistencyCheckerMgr::GetInstance()->stop();
+    DBRouterMgr::GetInstance()->stop();
+    ChangeLogMgr::GetInstance()->stop();
     return true;
 }
 
@@ -87,6 +101,11 @@ int32_t handle_request(sylar::http::HttpRequest::ptr request
 bool MyModule::onServerReady() {
     SYLAR_LOG_INFO(g_logger) << "onServerReady";
 
+    //登录只用签名令牌, 没有密钥不启动
+    if(!UserManager::CheckTokenSecret()) {
+        return false;
+    }
+
     auto work_path = sylar::Config::Lookup<std::string>("server.work_path");
     auto db_path = work_path->getValue() + "/" + g_sqlite3_db_name->getValue();
     sylar::SQLite3::ptr db;
@@ -114,6 +133,13 @@ bool MyModule::onServerReady() {
 #undef XX
         SYLAR_LOG_INFO(g_logger) << "init database end";
     }
+    if(!g_change_log_path->getValue().empty()) {
+        auto log_path = work_path->getValue() + "/" + g_change_log_path->getValue();
+        if(!ChangeLogMgr::GetInstance()->open(log_path)) {
+            SYLAR_LOG_ERROR(g_logger) << "open change log " << log_path << " failed";
+            return false;
+        }
+    }
 
     std::vector<sylar::TcpServer::ptr> servers;
     if(!sylar::Application::GetInstance()->getServer("http", servers)) {
@@ -121,10 +147,23 @@ bool MyModule::onServerReady() {
         return false;
     }
 
-#define XX(clazz) \
-    if(!clazz::GetInstance()->loadAll()) { \
-        SYLAR_LOG_ERROR(g_logger) << #clazz " load all fail"; \
+    //先写入心跳, 加载时才能判断副本延迟
+    DBRouterMgr::GetInstance()->start();
+
+    //老库补建增量加载用的索引, 新库建表时已按orm_config/article.xml创建
+    if(!EnsureIndex(GetDB(), "article", "article_update_time", "update_time")) {
+        SYLAR_LOG_WARN(g_logger) << "ensure index article_update_time failed";
     }
+
+    //各管理器使用独立连接并发加载
+    uint64_t load_ts = sylar::GetCurrentMS();
+    auto wg = sylar::WorkerGroup::Create(8);
+#define XX(clazz) \
+    wg->schedule([](){ \
+        if(!clazz::GetInstance()->loadAll()) { \
+            SYLAR_LOG_ERROR(g_logger) << #clazz " load all fail"; \
+        } \
+    });
     XX(UserMgr);
     XX(ArticleMgr);
     XX(ArticleCategoryRelMgr);
@@ -134,6 +173,10 @@ bool MyModule::onServerReady() {
     XX(LabelMgr);
     XX(CommentMgr);
 #undef XX
+    wg->waitAll();
+    ArticleMgr::GetInstance()->buildNeighbors();
+    SYLAR_LOG_INFO(g_logger) << "load all used: "
+        << (sylar::GetCurrentMS() - load_ts) << "ms";
 
     WordParserMgr::GetInstance();
     IndexMgr::GetInstance()->build();
@@ -198,6 +241,10 @@ bool MyModule::onServerReady() {
     }
 
     ArticleMgr::GetInstance()->start();
+    UserMgr::GetInstance()->start();
+    RateLimiterMgr::GetInstance()->start();
+    ConsistencyCheckerMgr::GetInstance()->start();
+    ChangeLogMgr::GetInstance()->start();
     return true;
 }
 
@@ -216,6 +263,11 @@ std::string MyModule::statusString() {
     ss << CommentMgr::GetInstance()->statusString() << std::endl;
     ss << ArticleLabelRelMgr::GetInstance()->statusString() << std::endl;
     ss << ArticleCategoryRelMgr::GetInstance()->statusString() << std::endl;
+    ss << ChangeLogMgr::GetInstance()->statusString() << std::endl;
+    ss << PasswdHasherMgr::GetInstance()->statusString() << std::endl;
+    ss << RateLimiterMgr::GetInstance()->statusString() << std::endl;
+    ss << DBRouterMgr::GetInstance()->statusString() << std::endl;
+    ss << ConsistencyCheckerMgr::GetInstance()->statusString() << std::endl;
 
     ss << "============================================" << std::endl;
     auto idx = IndexMgr::GetInstance()->get();
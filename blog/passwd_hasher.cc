@@ -0,0 +1,214 @@
+#include "passwd_hasher.h"
+#include "sylar/config.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include "sylar/worker.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <sstream>
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_ROOT();
+
+static sylar::ConfigVar<uint32_t>::ptr g_scrypt_log_n =
+    sylar::Config::Lookup("passwd.scrypt_log_n", (uint32_t)14, "scrypt cost, N = 2^log_n");
+static sylar::ConfigVar<uint32_t>::ptr g_max_pending =
+    sylar::Config::Lookup("passwd.max_pending", (uint32_t)64, "max password hash in flight");
+static sylar::ConfigVar<uint32_t>::ptr g_ip_max_pending =
+    sylar::Config::Lookup("passwd.ip_max_pending", (uint32_t)2, "max password hash in flight per ip");
+
+static const std::string s_prefix = "$scrypt$";
+static const uint32_t s_scrypt_r = 8;
+static const uint32_t s_scrypt_p = 1;
+static const size_t s_salt_len = 16;
+static const size_t s_hash_len = 32;
+
+static std::string ToHex(const unsigned char* data, size_t len) {
+    static const char s_hex[] = "0123456789abcdef";
+    std::string rt;
+    rt.reserve(len * 2);
+    for(size_t i = 0; i < len; ++i) {
+        rt.push_back(s_hex[data[i] >> 4]);
+        rt.push_back(s_hex[data[i] & 0xF]);
+    }
+    return rt;
+}
+
+static bool FromHex(const std::string& str, std::string& out) {
+    if(str.size() % 2) {
+        return false;
+    }
+    out.resize(str.size() / 2);
+    for(size_t i = 0; i < out.size(); ++i) {
+        char tmp[3] = {str[i * 2], str[i * 2 + 1], 0};
+        char* end = nullptr;
+        out[i] = (char)strtol(tmp, &end, 16);
+        if(*end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool Scrypt(const std::string& passwd, const std::string& salt
+                   ,uint32_t log_n, uint32_t r, uint32_t p, std::string& out) {
+    unsigned char buf[s_hash_len];
+    uint64_t n = (uint64_t)1 << log_n;
+    uint64_t maxmem = 128 * r * (n + p + 1) + 1024 * 1024;
+    if(EVP_PBE_scrypt(passwd.c_str(), passwd.size()
+                ,(const unsigned char*)salt.c_str(), salt.size()
+                ,n, r, p, maxmem, buf, sizeof(buf)) != 1) {
+        return false;
+    }
+    out.assign((const char*)buf, sizeof(buf));
+    return true;
+}
+
+//$scrypt$log_n$r$p$salt$hash
+static bool Encode(const std::string& passwd, std::string& out) {
+    unsigned char salt[s_salt_len];
+    if(RAND_bytes(salt, sizeof(salt)) != 1) {
+        return false;
+    }
+    uint32_t log_n = g_scrypt_log_n->getValue();
+    std::string hash;
+    if(!Scrypt(passwd, std::string((const char*)salt, sizeof(salt))
+                ,log_n, s_scrypt_r, s_scrypt_p, hash)) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << s_prefix << log_n << "$" << s_scrypt_r << "$" << s_scrypt_p
+       << "$" << ToHex(salt, sizeof(salt))
+       << "$" << ToHex((const unsigned char*)hash.c_str(), hash.size());
+    out = ss.str();
+    return true;
+}
+
+static bool Check(const std::string& passwd, const std::string& stored
+                  ,bool& match, bool& weak) {
+    auto parts = sylar::split(stored.substr(s_prefix.size()), '$');
+    if(parts.size() != 5) {
+        return false;
+    }
+    uint32_t log_n = sylar::TypeUtil::Atoi(parts[0]);
+    uint32_t r = sylar::TypeUtil::Atoi(parts[1]);
+    uint32_t p = sylar::TypeUtil::Atoi(parts[2]);
+    std::string salt, expect, hash;
+    if(log_n < 1 || log_n > 30 || !r || !p
+            || !FromHex(parts[3], salt) || !FromHex(parts[4], expect)
+            || expect.size() != s_hash_len) {
+        return false;
+    }
+    if(!Scrypt(passwd, salt, log_n, r, p, hash)) {
+        return false;
+    }
+    match = !CRYPTO_memcmp(hash.c_str(), expect.c_str(), s_hash_len);
+    weak = log_n < g_scrypt_log_n->getValue();
+    return true;
+}
+
+PasswdHasher::PasswdHasher()
+    :m_pending(0)
+    ,m_hashs(0)
+    ,m_rejects(0)
+    ,m_usedUs(0) {
+}
+
+bool PasswdHasher::IsHashed(const std::string& stored) {
+    return stored.compare(0, s_prefix.size(), s_prefix) == 0;
+}
+
+PasswdHasher::Status PasswdHasher::run(const std::string& ip, std::function<bool()> cb) {
+    sylar::Mutex::Lock lock(m_mutex);
+    auto& ip_pending = m_ips[ip];
+    if(m_pending >= g_max_pending->getValue()
+            || ip_pending >= g_ip_max_pending->getValue()) {
+        ++m_rejects;
+        if(!ip_pending) {
+            m_ips.erase(ip);
+        }
+        return BUSY;
+    }
+    ++m_pending;
+    ++ip_pending;
+    lock.unlock();
+
+    uint64_t ts = sylar::GetCurrentUS();
+    bool ok = false;
+    auto worker = sylar::WorkerMgr::GetInstance()->get("passwd");
+    if(worker) {
+        auto wg = sylar::WorkerGroup::Create(1, worker.get());
+        wg->schedule([&ok, &cb]() {
+            ok = cb();
+        });
+        wg->waitAll();
+    } else {
+        ok = cb();
+    }
+
+    lock.lock();
+    --m_pending;
+    auto it = m_ips.find(ip);
+    if(it != m_ips.end() && --it->second == 0) {
+        m_ips.erase(it);
+    }
+    ++m_hashs;
+    m_usedUs += sylar::GetCurrentUS() - ts;
+    return ok ? OK : ERROR;
+}
+
+PasswdHasher::Status PasswdHasher::hash(const std::string& passwd, std::string& out, const std::string& ip) {
+    auto rt = run(ip, [&passwd, &out]() {
+        return Encode(passwd, out);
+    });
+    if(rt == ERROR) {
+        SYLAR_LOG_ERROR(g_logger) << "scrypt hash fail";
+    }
+    return rt;
+}
+
+PasswdHasher::Status PasswdHasher::verify(const std::string& passwd, const std::string& stored
+                                          ,const std::string& ip, bool& need_rehash) {
+    need_rehash = false;
+    if(!IsHashed(stored)) {
+        //旧数据是明文, 比较不耗时, 不占线程池
+        if(stored.size() != passwd.size()
+                || CRYPTO_memcmp(stored.c_str(), passwd.c_str(), passwd.size())) {
+            return MISMATCH;
+        }
+        need_rehash = true;
+        return OK;
+    }
+    bool match = false;
+    bool weak = false;
+    auto rt = run(ip, [&]() {
+        return Check(passwd, stored, match, weak);
+    });
+    if(rt != OK) {
+        if(rt == ERROR) {
+            SYLAR_LOG_ERROR(g_logger) << "scrypt verify fail, invalid stored passwd?";
+        }
+        return rt;
+    }
+    if(!match) {
+        return MISMATCH;
+    }
+    need_rehash = weak;
+    return OK;
+}
+
+std::string PasswdHasher::statusString() {
+    std::stringstream ss;
+    sylar::Mutex::Lock lock(m_mutex);
+    ss << "PasswdHasher pending=" << m_pending
+       << " ips=" << m_ips.size()
+       << " hashs=" << m_hashs
+       << " rejects=" << m_rejects
+       << " avg_used=" << (m_hashs ? m_usedUs / m_hashs / 1000.0 : 0) << "ms"
+       << std::endl;
+    return ss.str();
+}
+
+}
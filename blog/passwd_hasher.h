@@ -0,0 +1,48 @@
+#ifndef __BLOG_PASSWD_HASHER_H__
+#define __BLOG_PASSWD_HASHER_H__
+
+#include "sylar/singleton.h"
+#include "sylar/mutex.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace blog {
+
+//密码哈希(scrypt), 在独立的passwd线程池中计算, 调用协程挂起等待结果
+//全局和单IP的并发数有上限, 超出直接拒绝, 避免登录风暴占满线程池
+class PasswdHasher {
+public:
+    enum Status {
+        OK       = 0,
+        MISMATCH = 1,
+        BUSY     = 2,
+        ERROR    = 3
+    };
+
+    PasswdHasher();
+
+    Status hash(const std::string& passwd, std::string& out, const std::string& ip);
+    //need_rehash: 存储的是旧格式(明文)或参数过低, 校验通过后应重新哈希
+    Status verify(const std::string& passwd, const std::string& stored
+                  ,const std::string& ip, bool& need_rehash);
+
+    static bool IsHashed(const std::string& stored);
+
+    std::string statusString();
+private:
+    Status run(const std::string& ip, std::function<bool()> cb);
+private:
+    sylar::Mutex m_mutex;
+    uint32_t m_pending;
+    std::unordered_map<std::string, uint32_t> m_ips;
+    uint64_t m_hashs;
+    uint64_t m_rejects;
+    uint64_t m_usedUs;
+};
+
+typedef sylar::Singleton<PasswdHasher> PasswdHasherMgr;
+
+}
+
+#endif
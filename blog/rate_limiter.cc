@@ -0,0 +1,189 @@
+#include "rate_limiter.h"
+#include "sylar/config.h"
+#include "sylar/iomanager.h"
+#include "sylar/log.h"
+#include "sylar/util.h"
+#include <sstream>
+
+namespace blog {
+
+static sylar::Logger::ptr g_logger = SYLAR_LOG_NAME("system");
+
+static sylar::ConfigVar<RateLimiter::RuleMap>::ptr g_rate_limit_rules =
+    sylar::Config::Lookup("rate_limit.rules", RateLimiter::RuleMap()
+            ,"rate limit rules, uri => {ip_rate, ip_burst, user_rate, user_burst}");
+
+static sylar::ConfigVar<uint32_t>::ptr g_rate_limit_sweep_interval =
+    sylar::Config::Lookup("rate_limit.sweep_interval", (uint32_t)60000, "rate limit idle bucket sweep interval ms");
+
+RateLimiter::Rule::Rule()
+    :ipRate(0)
+    ,ipBurst(0)
+    ,userRate(0)
+    ,userBurst(0) {
+}
+
+RateLimiter::RateLimiter()
+    :m_passed(0)
+    ,m_rejected(0) {
+    loadRules(g_rate_limit_rules->getValue());
+    g_rate_limit_rules->addListener([this](const RuleMap& old_value, const RuleMap& new_value){
+        loadRules(new_value);
+    });
+}
+
+void RateLimiter::loadRules(const RuleMap& v) {
+    std::unordered_map<std::string, Rule> rules;
+    for(auto& i : v) {
+        Rule rule;
+#define XX(m, name) \
+        { \
+            auto it = i.second.find(name); \
+            if(it != i.second.end() && it->second > 0) { \
+                rule.m = it->second; \
+            } \
+        }
+        XX(ipRate, "ip_rate");
+        XX(ipBurst, "ip_burst");
+        XX(userRate, "user_rate");
+        XX(userBurst, "user_burst");
+#undef XX
+        //未配置burst时允许一分钟的量
+        if(rule.ipRate && !rule.ipBurst) {
+            rule.ipBurst = rule.ipRate;
+        }
+        if(rule.userRate && !rule.userBurst) {
+            rule.userBurst = rule.userRate;
+        }
+        rules[i.first] = rule;
+    }
+    SYLAR_LOG_INFO(g_logger) << "rate limit rules=" << rules.size();
+    sylar::RWMutex::WriteLock lock(m_mutex);
+    m_rules.swap(rules);
+}
+
+bool RateLimiter::getRule(const std::string& path, Rule& rule, std::string& name) {
+    sylar::RWMutex::ReadLock lock(m_mutex);
+    auto it = m_rules.find(path);
+    if(it == m_rules.end()) {
+        it = m_rules.find("default");
+        if(it == m_rules.end()) {
+            return false;
+        }
+    }
+    rule = it->second;
+    name = it->first;
+    return true;
+}
+
+bool RateLimiter::take(uint64_t key, int64_t rate, int64_t burst
+                       ,uint64_t now, uint32_t& retry_after) {
+    int64_t cap = burst * 1000;
+    auto& shard = m_shards[key % s_shards];
+    sylar::Mutex::Lock lock(shard.mutex);
+    auto it = shard.buckets.find(key);
+    if(it == shard.buckets.end()) {
+        it = shard.buckets.insert(std::make_pair(key, Bucket{cap, now, now})).first;
+    }
+    auto& b = it->second;
+    if(now > b.last) {
+        b.tokens = std::min(cap, b.tokens + (int64_t)(now - b.last) * rate / 60);
+        b.last = now;
+    }
+    if(b.tokens < 1000) {
+        retry_after = ((1000 - b.tokens) * 60 / rate + 999) / 1000;
+        if(!retry_after) {
+            retry_after = 1;
+        }
+        return false;
+    }
+    b.tokens -= 1000;
+    b.full = now + (cap - b.tokens) * 60 / rate;
+    return true;
+}
+
+bool RateLimiter::check(const std::string& path, const std::string& ip
+                        ,int64_t uid, uint32_t& retry_after) {
+    Rule rule;
+    std::string name;
+    if(!getRule(path, rule, name)) {
+        return true;
+    }
+    uint64_t now = sylar::GetCurrentMS();
+    retry_after = 0;
+    bool rt = true;
+    if(rule.ipRate && !ip.empty()) {
+        std::string key = path + "|ip|" + ip;
+        rt = take(sylar::murmur3_hash64(key.c_str()), rule.ipRate
+                  ,rule.ipBurst, now, retry_after);
+    }
+    if(rt && rule.userRate && uid) {
+        std::string key = path + "|uid|" + std::to_string(uid);
+        rt = take(sylar::murmur3_hash64(key.c_str()), rule.userRate
+                  ,rule.userBurst, now, retry_after);
+    }
+    if(rt) {
+        ++m_passed;
+    } else {
+        ++m_rejected;
+        SYLAR_LOG_INFO(g_logger) << "rate limit rule=" << name << " path=" << path
+            << " ip=" << ip << " uid=" << uid;
+    }
+    return rt;
+}
+
+void RateLimiter::sweep() {
+    uint64_t now = sylar::GetCurrentMS();
+    for(size_t i = 0; i < s_shards; ++i) {
+        auto& shard = m_shards[i];
+        sylar::Mutex::Lock lock(shard.mutex);
+        for(auto it = shard.buckets.begin();
+                it != shard.buckets.end();) {
+            if(it->second.full <= now) {
+                shard.buckets.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void RateLimiter::start() {
+    sylar::Mutex::Lock lock(m_timerMutex);
+    if(m_timer) {
+        return;
+    }
+    m_timer = sylar::IOManager::GetThis()->addTimer(g_rate_limit_sweep_interval->getValue(),
+                std::bind(&RateLimiter::sweep, this), true);
+}
+
+void RateLimiter::stop() {
+    sylar::Mutex::Lock lock(m_timerMutex);
+    if(!m_timer) {
+        return;
+    }
+    m_timer->cancel();
+    m_timer = nullptr;
+}
+
+std::string RateLimiter::statusString() {
+    size_t buckets = 0;
+    for(size_t i = 0; i < s_shards; ++i) {
+        sylar::Mutex::Lock lock(m_shards[i].mutex);
+        buckets += m_shards[i].buckets.size();
+    }
+    size_t rules = 0;
+    {
+        sylar::RWMutex::ReadLock lock(m_mutex);
+        rules = m_rules.size();
+    }
+    std::stringstream ss;
+    ss << "RateLimiter rules=" << rules
+       << " buckets=" << buckets
+       << " passed=" << m_passed
+       << " rejected=" << m_rejected
+       << std::endl;
+    return ss.str();
+}
+
+}
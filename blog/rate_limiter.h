@@ -0,0 +1,74 @@
+#ifndef __BLOG_RATE_LIMITER_H__
+#define __BLOG_RATE_LIMITER_H__
+
+#include "sylar/singleton.h"
+#include "sylar/mutex.h"
+#include "sylar/timer.h"
+#include <atomic>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace blog {
+
+//按ip/用户/接口的令牌桶限流, 规则来自rate_limit.rules
+//rules的key为uri, default对未单独配置的uri生效, 速率单位为次/分钟
+class RateLimiter {
+public:
+    typedef std::map<std::string, std::map<std::string, int64_t> > RuleMap;
+
+    struct Rule {
+        Rule();
+        int64_t ipRate;
+        int64_t ipBurst;
+        int64_t userRate;
+        int64_t userBurst;
+    };
+
+    RateLimiter();
+
+    //超限返回false, retry_after为建议等待的秒数
+    bool check(const std::string& path, const std::string& ip
+               ,int64_t uid, uint32_t& retry_after);
+
+    void start();
+    void stop();
+
+    std::string statusString();
+private:
+    //tokens以1/1000个令牌计, full为桶重新装满的时间
+    struct Bucket {
+        int64_t tokens;
+        uint64_t last;
+        uint64_t full;
+    };
+
+    struct Shard {
+        sylar::Mutex mutex;
+        std::unordered_map<uint64_t, Bucket> buckets;
+    };
+
+    bool take(uint64_t key, int64_t rate, int64_t burst
+              ,uint64_t now, uint32_t& retry_after);
+    bool getRule(const std::string& path, Rule& rule, std::string& name);
+    void loadRules(const RuleMap& v);
+    void sweep();
+private:
+    static const size_t s_shards = 16;
+
+    sylar::RWMutex m_mutex;
+    std::unordered_map<std::string, Rule> m_rules;
+    Shard m_shards[s_shards];
+
+    sylar::Mutex m_timerMutex;
+    sylar::Timer::ptr m_timer;
+
+    std::atomic<uint64_t> m_passed;
+    std::atomic<uint64_t> m_rejected;
+};
+
+typedef sylar::Singleton<RateLimiter> RateLimiterMgr;
+
+}
+
+#endif
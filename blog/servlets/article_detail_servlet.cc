@@ -13,6 +13,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/json_writer.h"
 #include <regex>
 
 namespace blog {
@@ -24,6 +25,48 @@ ArticleDetailServlet::ArticleDetailServlet()
     :BlogServlet("ArticleDetail") {
 }
 
+bool ArticleDetailServlet::getETag(sylar::http::HttpRequest::ptr request
+                                  ,std::string& etag, time_t& last_modified, bool& personal) {
+    int64_t id = request->getParamAs<int64_t>("id");
+    auto info = ArticleMgr::GetInstance()->get(id);
+    if(!info) {
+        return false;
+    }
+    uint64_t version = ArticleMgr::GetInstance()->getVersion(id);
+    std::stringstream ss;
+    ss << "article:" << id << ":" << version
+       << ":" << info->getViews()
+       << ":" << info->getPraise()
+       << ":" << info->getFavorites()
+       << ":" << ChannelMgr::GetInstance()->getVersion(info->getChannel());
+
+    //分类/标签被删除时文章本身版本不变, 取关联实体的版本
+    auto cats = ArticleCategoryRelMgr::GetInstance()->getIndex()->listByArticleId(id);
+    if(cats) {
+        for(auto& i : *cats) {
+            ss << ":c" << CategoryMgr::GetInstance()->getVersion(i.id);
+        }
+    }
+    auto labels = ArticleLabelRelMgr::GetInstance()->getIndex()->listByArticleId(id);
+    if(labels) {
+        for(auto& i : *labels) {
+            ss << ":l" << LabelMgr::GetInstance()->getVersion(i.id);
+        }
+    }
+
+    int64_t uid = getUserId(request);
+    if(uid) {
+        ss << ":u" << uid
+           << ":" << ArticleMgr::GetInstance()->hasPraise(id, uid)
+           << ":" << ArticleMgr::GetInstance()->hasFavorites(id, uid);
+        personal = true;
+    }
+    etag = HashETag(ss.str());
+    //计数没有修改时间, 不输出Last-Modified, 只靠etag校验
+    last_modified = 0;
+    return true;
+}
+
 int32_t ArticleDetailServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,sylar::http::HttpResponse::ptr response
                                   ,sylar::http::HttpSession::ptr session
@@ -35,45 +78,76 @@ int32_t ArticleDetailServlet::handle(sylar::http::HttpRequest::ptr request
             result->setResult(404, "invalid id");
             break;
         }
-        result->setResult(200, "ok");
-        result->set("id", info->getId());
-        result->set("title", info->getTitle());
-        result->set("content", info->getContent());
-        result->set("user_id", info->getUserId());
-        result->set("type", info->getType());
-        result->set("publish_time", info->getPublishTime());
-        result->set("state", info->getState());
-        result->set("is_deleted", info->getIsDeleted());
-        result->set("views", info->getViews());
-        result->set("praise", info->getPraise());
-        result->set("favorites", info->getFavorites());
-
-        result->set("channel_id", info->getChannel());
-        auto cinfo = ChannelMgr::GetInstance()->get(info->getChannel());
-        if(cinfo) {
-            result->set("channel_name", cinfo->getName());
-        }
-
+        //有待修补的关系时先发布索引, 发布时使受影响文章的片段失效
+        ArticleCategoryRelMgr::GetInstance()->getIndex();
+        ArticleLabelRelMgr::GetInstance()->getIndex();
+        ArticleRenderCache::Fragment::ptr frag;
+        if(!ArticleMgr::GetInstance()->render(ArticleRenderCache::DETAIL, id
+                    ,[id](Json::Value& v) {
+            auto info = ArticleMgr::GetInstance()->get(id);
+            std::string content;
+            if(!info || !ArticleMgr::GetInstance()->getContent(id, content)) {
+                return false;
+            }
+            v["id"] = info->getId();
+            v["title"] = info->getTitle();
+            v["content"] = content;
+            v["user_id"] = info->getUserId();
+            v["type"] = info->getType();
+            v["publish_time"] = info->getPublishTime();
+            v["state"] = info->getState();
+            v["is_deleted"] = info->getIsDeleted();
+            v["channel_id"] = info->getChannel();
 
-        std::vector<data::ArticleCategoryRelInfo::ptr> cinfos;
-        ArticleCategoryRelMgr::GetInstance()->listByArticleId(cinfos, id, true);
+            //索引在渲染内读取, 其后发布的修补会bump本文章使结果不入缓存
+            auto cat_idx = ArticleCategoryRelMgr::GetInstance()->getIndex();
+            auto cats = cat_idx->listByArticleId(id);
+            if(cats) {
+                for(auto& i : *cats) {
+                    if(!i.deleted) {
+                        v["categorys"].append(i.id);
+                    }
+                }
+            }
 
-        for(auto& i : cinfos) {
-            auto c = CategoryMgr::GetInstance()->get(i->getCategoryId());
-            if(c && c->getIsDeleted() == 0) {
-                result->append("categorys", c->getId());
+            auto label_idx = ArticleLabelRelMgr::GetInstance()->getIndex();
+            auto labels = label_idx->listByArticleId(id);
+            if(labels) {
+                for(auto& i : *labels) {
+                    if(!i.deleted) {
+                        v["labels"].append(i.id);
+                    }
+                }
             }
+            return true;
+        }, frag)) {
+            result->setResult(500, "load content fail");
+            break;
         }
 
-        std::vector<data::ArticleLabelRelInfo::ptr> linfos;
-        ArticleLabelRelMgr::GetInstance()->listByArticleId(linfos, id, true);
+        std::string data;
+        JsonWriter w(data);
+        size_t off = w.openObject(frag->json);
+        if(frag->gzip) {
+            result->pieces.push_back(std::make_pair(off, frag->gzip));
+        }
+        w.set("views", info->getViews());
+        w.set("praise", info->getPraise());
+        w.set("favorites", info->getFavorites());
 
-        for(auto& i : linfos) {
-            auto l = LabelMgr::GetInstance()->get(i->getLabelId());
-            if(l && l->getIsDeleted() == 0) {
-                result->append("labels", l->getId());
-            }
+        int64_t uid = getUserId(request);
+        if(uid) {
+            w.set("is_praise", ArticleMgr::GetInstance()->hasPraise(id, uid) ? 1 : 0);
+            w.set("is_favorites", ArticleMgr::GetInstance()->hasFavorites(id, uid) ? 1 : 0);
         }
+
+        auto cinfo = ChannelMgr::GetInstance()->get(info->getChannel());
+        if(cinfo) {
+            w.set("channel_name", cinfo->getName());
+        }
+        w.endObject();
+        result->setResult(200, "ok");
+        result->rawdata.swap(data);
     } while(false);
     
     response->setBody(result->toJsonString());
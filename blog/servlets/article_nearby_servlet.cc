@@ -30,14 +30,32 @@ int32_t ArticleNearbyServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,Result::ptr result) {
     do {
         DEFINE_AND_CHECK_TYPE(result,int64_t, id, "id");
-        auto v = ArticleMgr::GetInstance()->nearby(id);
-        if(v.first) {
-            result->set("prev_id", v.first->getId());
-            result->set("prev_name", v.first->getTitle());
+        //可选按用户/频道/分类/标签范围取前后篇
+        ArticleNeighbors::Type type = ArticleNeighbors::GLOBAL;
+        int64_t key = 0;
+#define XX(t, name) \
+        if(!key) { \
+            key = request->getParamAs<int64_t>(name); \
+            type = ArticleNeighbors::t; \
         }
-        if(v.second) {
-            result->set("next_id", v.second->getId());
-            result->set("next_name", v.second->getTitle());
+        XX(CATEGORY, "category_id");
+        XX(LABEL, "label_id");
+        XX(CHANNEL, "channel_id");
+        XX(USER, "user_id");
+#undef XX
+        if(!key) {
+            type = ArticleNeighbors::GLOBAL;
+        }
+        ArticleView prev;
+        ArticleView next;
+        ArticleMgr::GetInstance()->nearby(id, prev, next, type, key);
+        if(prev.id) {
+            result->set("prev_id", prev.id);
+            result->set("prev_name", prev.title);
+        }
+        if(next.id) {
+            result->set("next_id", next.id);
+            result->set("next_name", next.title);
         }
         result->setResult(200, "ok");
     } while(false);
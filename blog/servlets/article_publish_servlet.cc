@@ -8,6 +8,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -55,16 +56,8 @@ int32_t ArticlePublishServlet::handle(sylar::http::HttpRequest::ptr request
             info->setPublishTime(now);
         }
         info->setUpdateTime(time(0));
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::ArticleInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "update article fail");
-
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
         ArticleMgr::GetInstance()->add(info);
@@ -9,6 +9,7 @@
 #include "blog/util.h"
 #include "blog/struct.h"
 #include "blog/index.h"
+#include "blog/json_writer.h"
 #include <regex>
 
 namespace blog {
@@ -64,12 +65,20 @@ int32_t ArticleQueryServlet::handle(sylar::http::HttpRequest::ptr request
         //auto total = ArticleMgr::GetInstance()->listByUserIdPages(infos
         //            ,user_id, page_from, page_size, true, state);
         result->setResult(200, "ok");
-        result->jsondata["total"] = total;
-        result->jsondata["page_from"] = page_from;
-        result->jsondata["page_size"] = page_size;
+        std::string data;
+        JsonWriter w(data);
+        w.startObject();
+        w.set("total", total);
+        w.set("page_from", page_from);
+        w.set("page_size", page_size);
+        w.key("ids");
+        w.startArray();
         for(size_t i = page_from, c = 0; (int64_t)c < page_size && i < ids.size(); ++i, ++c) {
-            result->jsondata["ids"].append(ids[i]);
+            w.append(ids[i]);
         }
+        w.endArray();
+        w.endObject();
+        result->rawdata.swap(data);
         //for(auto& i : infos) {
         //    result->jsondata["ids"].append(i->getId());
         //}
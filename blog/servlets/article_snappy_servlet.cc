@@ -14,6 +14,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/json_writer.h"
 #include <regex>
 
 namespace blog {
@@ -32,66 +33,106 @@ int32_t ArticleSnappyServlet::handle(sylar::http::HttpRequest::ptr request
     do {
         DEFINE_AND_CHECK_STRING(result, ids, "ids");
         auto tmp = sylar::split(ids, ",");
+        std::vector<int64_t> aids;
+        aids.reserve(tmp.size());
         for(auto& x : tmp) {
             auto id = sylar::TypeUtil::Atoi(x);
-            if(!id) {
-                continue;
-            }
-            data::ArticleInfo::ptr info = ArticleMgr::GetInstance()->get(id);
-            if(!info) {
-                continue;
-            }
-            Json::Value v;
-            v["id"] = info->getId();
-            v["title"] = info->getTitle();
-            v["content"] = get_max_length_string(info->getContent(), 100);
-            v["user_id"] = info->getUserId();
-            auto uinfo = UserMgr::GetInstance()->get(info->getUserId());
-            if(uinfo) {
-                v["user_name"] = uinfo->getName();
-            } else {
-                v["user_name"] = "system";
+            if(id) {
+                aids.push_back(id);
             }
-            v["type"] = info->getType();
-            v["publish_time"] = info->getPublishTime();
-            v["views"] = info->getViews();
-            v["praise"] = info->getPraise();
-            v["favorites"] = info->getFavorites();
+        }
+
+        //每个管理器只加一次锁批量取数据, 标题和摘要只在片段未命中时由渲染读取
+        std::vector<ArticleView> infos;
+        ArticleMgr::GetInstance()->viewMany(aids, infos, false);
+        std::vector<int64_t> uids(infos.size());
+        std::vector<int64_t> chids(infos.size());
+        for(size_t i = 0; i < infos.size(); ++i) {
+            uids[i] = infos[i].userId;
+            chids[i] = infos[i].channel;
+        }
+        std::vector<data::UserInfo::ptr> uinfos;
+        UserMgr::GetInstance()->getMany(uids, uinfos);
+        std::vector<data::ChannelInfo::ptr> cinfos;
+        ChannelMgr::GetInstance()->getMany(chids, cinfos);
+        //有待修补的关系时先发布索引, 发布时使受影响文章的片段失效
+        ArticleCategoryRelMgr::GetInstance()->getIndex();
+        ArticleLabelRelMgr::GetInstance()->getIndex();
 
-            v["channel_id"] = info->getChannel();
-            auto cinfo = ChannelMgr::GetInstance()->get(info->getChannel());
-            if(cinfo) {
-                v["channel_name"] = cinfo->getName();
+        std::string data;
+        JsonWriter w(data);
+        w.startArray();
+        size_t count = 0;
+        for(size_t n = 0; n < infos.size(); ++n) {
+            auto& info = infos[n];
+            if(!info.id) {
+                continue;
             }
+            int64_t id = info.id;
+            ArticleRenderCache::Fragment::ptr frag;
+            if(!ArticleMgr::GetInstance()->render(ArticleRenderCache::SNAPPY, id
+                        ,[id](Json::Value& v) {
+                ArticleView info;
+                if(!ArticleMgr::GetInstance()->view(id, info)) {
+                    return false;
+                }
+                v["id"] = info.id;
+                v["title"] = info.title;
+                v["content"] = info.summary;
+                v["user_id"] = info.userId;
+                v["type"] = info.type;
+                v["publish_time"] = info.publishTime;
+                v["channel_id"] = info.channel;
 
-            std::vector<data::ArticleCategoryRelInfo::ptr> cinfos;
-            ArticleCategoryRelMgr::GetInstance()->listByArticleId(cinfos, id, true);
+                //索引在渲染内读取, 其后发布的修补会bump本文章使结果不入缓存
+                auto cat_idx = ArticleCategoryRelMgr::GetInstance()->getIndex();
+                auto cats = cat_idx->listByArticleId(id);
+                if(cats) {
+                    for(auto& i : *cats) {
+                        if(!i.deleted) {
+                            Json::Value vv;
+                            vv["id"] = i.id;
+                            vv["name"] = i.name;
+                            v["categorys"].append(vv);
+                        }
+                    }
+                }
 
-            for(auto& i : cinfos) {
-                auto c = CategoryMgr::GetInstance()->get(i->getCategoryId());
-                if(c && c->getIsDeleted() == 0) {
-                    Json::Value vv;
-                    vv["id"] = c->getId();
-                    vv["name"] = c->getName();
-                    v["categorys"].append(vv);
-                    //result->append("categorys", c->getId());
+                auto label_idx = ArticleLabelRelMgr::GetInstance()->getIndex();
+                auto labels = label_idx->listByArticleId(id);
+                if(labels) {
+                    for(auto& i : *labels) {
+                        if(!i.deleted) {
+                            Json::Value vv;
+                            vv["id"] = i.id;
+                            vv["name"] = i.name;
+                            v["labels"].append(vv);
+                        }
+                    }
                 }
+                return true;
+            }, frag)) {
+                continue;
             }
 
-            std::vector<data::ArticleLabelRelInfo::ptr> linfos;
-            ArticleLabelRelMgr::GetInstance()->listByArticleId(linfos, id, true);
-
-            for(auto& i : linfos) {
-                auto l = LabelMgr::GetInstance()->get(i->getLabelId());
-                if(l && l->getIsDeleted() == 0) {
-                    //result->append("labels", l->getId());
-                    Json::Value vv;
-                    vv["id"] = l->getId();
-                    vv["name"] = l->getName();
-                    v["labels"].append(vv);
-                }
+            //计数和用户/频道名变化频繁, 不进片段
+            size_t off = w.openObject(frag->json);
+            if(frag->gzip) {
+                result->pieces.push_back(std::make_pair(off, frag->gzip));
+            }
+            w.set("user_name", uinfos[n] ? uinfos[n]->getName() : std::string("system"));
+            w.set("views", info.views);
+            w.set("praise", info.praise);
+            w.set("favorites", info.favorites);
+            if(cinfos[n]) {
+                w.set("channel_name", cinfos[n]->getName());
             }
-            result->jsondata.append(v);
+            w.endObject();
+            ++count;
+        }
+        w.endArray();
+        if(count) {
+            result->rawdata.swap(data);
         }
         result->setResult(200, "ok");
     } while(false);
@@ -10,6 +10,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -81,10 +82,6 @@ int32_t ArticleUpdateLabelServlet::handle(sylar::http::HttpRequest::ptr request
                     acinfo->setIsDeleted(0);
                     acinfo->setUpdateTime(now);
                     update_add_infos.push_back(acinfo);
-                    if(data::ArticleLabelRelInfoDao::Update(acinfo, db)) {
-                        SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                            << " errstr=" << db->getErrStr();
-                    }
                 }
             } else {
                 acinfo.reset(new data::ArticleLabelRelInfo);
@@ -118,14 +115,11 @@ int32_t ArticleUpdateLabelServlet::handle(sylar::http::HttpRequest::ptr request
                     acinfo->setUpdateTime(now);
                     new_infos.push_back(acinfo);
                     update_del_infos.push_back(acinfo);
-                    if(data::ArticleLabelRelInfoDao::Update(acinfo, db)) {
-                        SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                            << " errstr=" << db->getErrStr();
-                    }
                 }
             }
         }
 
+        //新建关系依赖自增id, 事务内同步插入; 状态变更走ChangeLog
         if(!trans->commit()) {
             for(auto& i : update_add_infos) {
                 i->setIsDeleted(1);
@@ -140,6 +134,21 @@ int32_t ArticleUpdateLabelServlet::handle(sylar::http::HttpRequest::ptr request
         for(auto& i : new_infos) {
             ArticleLabelRelMgr::GetInstance()->add(i);
         }
+
+        std::vector<data::ArticleLabelRelInfo::ptr> update_infos(update_add_infos);
+        update_infos.insert(update_infos.end(), update_del_infos.begin(), update_del_infos.end());
+        if(ChangeLogMgr::GetInstance()->update(update_infos)) {
+            for(auto& i : update_add_infos) {
+                i->setIsDeleted(1);
+            }
+            for(auto& i : update_del_infos) {
+                i->setIsDeleted(0);
+            }
+            result->setResult(500, "commit fail");
+            break;
+        }
+        ArticleLabelRelMgr::GetInstance()->refresh(id);
+        ArticleMgr::GetInstance()->refresh(ainfo);
         result->setResult(200, "ok");
         if(!update_add_infos.empty()) {
             auto& v = result->jsondata["add_label_ids"];
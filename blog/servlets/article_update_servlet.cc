@@ -9,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -72,26 +73,23 @@ int32_t ArticleUpdateServlet::handle(sylar::http::HttpRequest::ptr request
             info->setTitle(title);
         }
 
-        if(!content.empty()) {
-            info->setContent(content);
-        }
         if(type) {
             info->setType(type);
         }
         info->setState((int)State::VERIFYING);
         ArticleMgr::GetInstance()->addVerify(info);
         info->setUpdateTime(time(0));
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::ArticleInfoDao::Update(info, db)) {
+        if(!content.empty()) {
+            //元数据与正文同批写日志
+            if(!ArticleMgr::GetInstance()->updateContent(info, content)) {
+                result->setResult(500, "update content fail");
+                break;
+            }
+        } else if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "update article fail");
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
+        ArticleMgr::GetInstance()->refresh(info);
         result->setResult(200, "ok");
         SendWX("blog", "[" + std::to_string(uid) + "]更新文章[" + title + "], 需要审核");
     } while(false);
@@ -9,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -78,19 +79,12 @@ int32_t ArticleVerifyServlet::handle(sylar::http::HttpRequest::ptr request
         }
         info->setUpdateTime(time(0));
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::ArticleInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "insert article fail");
             info->setState((int)State::VERIFYING);
-
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
+        ArticleMgr::GetInstance()->refresh(info);
         result->setResult(200, "ok");
     } while(false);
     
@@ -1,6 +1,7 @@
 #include "category_create_servlet.h"
 #include "sylar/log.h"
 #include "blog/manager/category_manager.h"
+#include "blog/manager/article_category_rel_manager.h"
 #include "sylar/util.h"
 #include "blog/my_module.h"
 #include "sylar/email/smtp.h"
@@ -8,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -55,16 +57,20 @@ int32_t CategoryCreateServlet::handle(sylar::http::HttpRequest::ptr request
         info->setCreateTime(time(0));
         info->setUpdateTime(time(0));
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-
-        if(data::CategoryInfoDao::InsertOrUpdate(info, db)) {
+        if(new_cat) {
+            auto db = getDB();
+            if(!db) {
+                result->setResult(500, "get db error");
+                break;
+            }
+            if(data::CategoryInfoDao::InsertOrUpdate(info, db)) {
+                result->setResult(500, "insert or update category fail");
+                SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
+                    << " errstr=" << db->getErrStr();
+                break;
+            }
+        } else if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "insert or update category fail");
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
 
@@ -72,6 +78,8 @@ int32_t CategoryCreateServlet::handle(sylar::http::HttpRequest::ptr request
             CategoryMgr::GetInstance()->add(info);
         }
 
+        CategoryMgr::GetInstance()->refresh(info);
+        ArticleCategoryRelMgr::GetInstance()->refresh();
         result->setResult(200, "ok");
         result->set("id", info->getId());
         result->set("name", info->getName());
@@ -1,6 +1,7 @@
 #include "category_delete_servlet.h"
 #include "sylar/log.h"
 #include "blog/manager/category_manager.h"
+#include "blog/manager/article_category_rel_manager.h"
 #include "sylar/util.h"
 #include "blog/my_module.h"
 #include "sylar/email/smtp.h"
@@ -8,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -73,23 +75,13 @@ int32_t CategoryDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             get_delete_values(parent_map, i, del_cats);
         }
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        auto trans = db->openTransaction();
-        if(!trans) {
-            result->setResult(500, "open transaction fail");
-            break;
-        }
         time_t now = time(0);
         for(auto& i : del_cats) {
             i->setIsDeleted(1);
             i->setUpdateTime(now);
-            data::CategoryInfoDao::Update(i, db);
         }
-        if(!trans->commit()) {
+        std::vector<data::CategoryInfo::ptr> dinfos(del_cats.begin(), del_cats.end());
+        if(ChangeLogMgr::GetInstance()->update(dinfos)) {
             SYLAR_LOG_ERROR(g_logger) << "commit fail";
             result->setResult(500, "commit fail");
 
@@ -98,6 +90,10 @@ int32_t CategoryDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             }
             break;
         }
+        for(auto& i : del_cats) {
+            CategoryMgr::GetInstance()->refresh(i);
+        }
+        ArticleCategoryRelMgr::GetInstance()->refresh();
         result->setResult(200, "ok");
         if(!del_cats.empty()) {
             auto& jids = result->jsondata["ids"];
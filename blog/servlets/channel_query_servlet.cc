@@ -19,6 +19,14 @@ ChannelQueryServlet::ChannelQueryServlet()
     :BlogServlet("ChannelQuery") {
 }
 
+bool ChannelQueryServlet::getETag(sylar::http::HttpRequest::ptr request
+                                  ,std::string& etag, time_t& last_modified, bool& personal) {
+    uint64_t v = ChannelMgr::GetInstance()->getVersion();
+    etag = HashETag("channel:" + std::to_string(v));
+    last_modified = EntityVersion::ToTime(v);
+    return true;
+}
+
 int32_t ChannelQueryServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,sylar::http::HttpResponse::ptr response
                                   ,sylar::http::HttpSession::ptr session
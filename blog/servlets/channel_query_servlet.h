@@ -15,6 +15,9 @@ public:
                    ,sylar::http::HttpResponse::ptr response
                    ,sylar::http::HttpSession::ptr session
                    ,Result::ptr result) override;
+protected:
+    bool getETag(sylar::http::HttpRequest::ptr request
+                 ,std::string& etag, time_t& last_modified, bool& personal) override;
 };
 
 }
@@ -8,6 +8,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -48,25 +49,12 @@ int32_t CommentDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             infos.push_back(info);
         }
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        auto trans = db->openTransaction();
-        if(!trans) {
-            result->setResult(500, "open transaction fail");
-            break;
-        }
         time_t now = time(0);
         for(auto& i : infos) {
             i->setIsDeleted(1);
             i->setUpdateTime(now);
-            data::CommentInfoDao::Update(i, db);
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
         }
-        if(!trans->commit()) {
+        if(ChangeLogMgr::GetInstance()->update(infos)) {
             SYLAR_LOG_ERROR(g_logger) << "commit fail";
             result->setResult(500, "commit fail");
 
@@ -75,6 +63,9 @@ int32_t CommentDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             }
             break;
         }
+        for(auto& i : infos) {
+            CommentMgr::GetInstance()->refresh(i);
+        }
         result->setResult(200, "ok");
         if(!infos.empty()) {
             auto& jids = result->jsondata["ids"];
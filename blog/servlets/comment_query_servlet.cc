@@ -8,6 +8,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/json_writer.h"
 #include <regex>
 
 namespace blog {
@@ -27,16 +28,17 @@ int32_t CommentQueryServlet::handle(sylar::http::HttpRequest::ptr request
         DEFINE_AND_CHECK_TYPE(result, int64_t, id, "id");
         int64_t page_from = request->getParamAs<int64_t>("page_from");
         int64_t page_size = request->getParamAs<int64_t>("page_size", 20);
-        std::vector<data::CommentInfo::ptr> infos;
-        auto total = CommentMgr::GetInstance()->listByArticleId(infos
-                    ,id, page_from, page_size, true);
+        bool tree = request->getParamAs<int32_t>("tree") != 0;
+        auto thread = CommentMgr::GetInstance()->getThread(id);
+        auto page = thread->getPage(page_from, page_size, tree);
         result->setResult(200, "ok");
-        result->jsondata["total"] = total;
-        result->jsondata["page_from"] = page_from;
-        result->jsondata["page_size"] = page_size;
-        for(auto& i : infos) {
-            result->jsondata["ids"].append(i->getId());
-        }
+        std::string data;
+        JsonWriter w(data);
+        w.openObject(*page);
+        w.set("page_from", page_from);
+        w.set("page_size", page_size);
+        w.endObject();
+        result->rawdata.swap(data);
     } while(false);
     
     response->setBody(result->toJsonString());
@@ -9,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -70,20 +71,12 @@ int32_t CommentVerifyServlet::handle(sylar::http::HttpRequest::ptr request
         info->setState(state);
         info->setUpdateTime(time(0));
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-
-        if(data::CommentInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "insert comment fail");
             info->setState((int)State::VERIFYING);
-
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
+        CommentMgr::GetInstance()->refresh(info);
         result->setResult(200, "ok");
     } while(false);
     
@@ -1,6 +1,7 @@
 #include "label_create_servlet.h"
 #include "sylar/log.h"
 #include "blog/manager/label_manager.h"
+#include "blog/manager/article_label_rel_manager.h"
 #include "sylar/util.h"
 #include "blog/my_module.h"
 #include "sylar/email/smtp.h"
@@ -8,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -43,22 +45,30 @@ int32_t LabelCreateServlet::handle(sylar::http::HttpRequest::ptr request
         info->setCreateTime(time(0));
         info->setUpdateTime(time(0));
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::LabelInfoDao::InsertOrUpdate(info, db)) {
+        if(new_label) {
+            auto db = getDB();
+            if(!db) {
+                result->setResult(500, "get db error");
+                break;
+            }
+            if(data::LabelInfoDao::InsertOrUpdate(info, db)) {
+                result->setResult(500, "insert or update label fail");
+                SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
+                    << " errstr=" << db->getErrStr();
+                break;
+            }
+        } else if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "insert or update label fail");
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
 
         if(new_label) {
             LabelMgr::GetInstance()->add(info);
+        } else {
+            LabelMgr::GetInstance()->refresh(info);
         }
 
+        ArticleLabelRelMgr::GetInstance()->refresh();
         result->setResult(200, "ok");
         result->set("id", info->getId());
         result->set("name", info->getName());
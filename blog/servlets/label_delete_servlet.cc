@@ -1,6 +1,7 @@
 #include "label_delete_servlet.h"
 #include "sylar/log.h"
 #include "blog/manager/label_manager.h"
+#include "blog/manager/article_label_rel_manager.h"
 #include "sylar/util.h"
 #include "blog/my_module.h"
 #include "sylar/email/smtp.h"
@@ -8,6 +9,7 @@
 #include "sylar/sylar.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include <regex>
 
 namespace blog {
@@ -49,23 +51,12 @@ int32_t LabelDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             }
         }
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        auto trans = db->openTransaction();
-        if(!trans) {
-            result->setResult(500, "open transaction fail");
-            break;
-        }
         time_t now = time(0);
         for(auto& i : dinfos) {
             i->setIsDeleted(1);
             i->setUpdateTime(now);
-            data::LabelInfoDao::Update(i, db);
         }
-        if(!trans->commit()) {
+        if(ChangeLogMgr::GetInstance()->update(dinfos)) {
             SYLAR_LOG_ERROR(g_logger) << "commit fail";
             result->setResult(500, "commit fail");
 
@@ -74,6 +65,10 @@ int32_t LabelDeleteServlet::handle(sylar::http::HttpRequest::ptr request
             }
             break;
         }
+        for(auto& i : dinfos) {
+            LabelMgr::GetInstance()->refresh(i);
+        }
+        ArticleLabelRelMgr::GetInstance()->refresh();
         result->setResult(200, "ok");
         if(!dinfos.empty()) {
             auto& jids = result->jsondata["ids"];
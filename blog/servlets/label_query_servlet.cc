@@ -19,6 +19,33 @@ LabelQueryServlet::LabelQueryServlet()
     :BlogServlet("LabelQuery") {
 }
 
+bool LabelQueryServlet::getETag(sylar::http::HttpRequest::ptr request
+                                  ,std::string& etag, time_t& last_modified, bool& personal) {
+    int64_t user_id = request->getParamAs<int64_t>("user_id");
+    std::string ids = request->getParam("ids");
+    if(user_id == 0 && ids.empty()) {
+        return false;
+    }
+    std::stringstream ss;
+    uint64_t max_version = 0;
+    if(user_id) {
+        max_version = LabelMgr::GetInstance()->getUserVersion(user_id);
+        ss << "label:u" << user_id << ":" << max_version;
+    } else {
+        ss << "label:i";
+        auto tmp = sylar::split(ids, ',');
+        for(auto& i : tmp) {
+            auto id = sylar::TypeUtil::Atoi(i);
+            auto v = LabelMgr::GetInstance()->getVersion(id);
+            max_version = std::max(max_version, v);
+            ss << ":" << id << ":" << v;
+        }
+    }
+    etag = HashETag(ss.str());
+    last_modified = EntityVersion::ToTime(max_version);
+    return true;
+}
+
 int32_t LabelQueryServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,sylar::http::HttpResponse::ptr response
                                   ,sylar::http::HttpSession::ptr session
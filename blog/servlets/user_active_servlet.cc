@@ -1,6 +1,7 @@
 #include "user_active_servlet.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include "blog/manager/user_manager.h"
 
 namespace blog {
@@ -47,16 +48,9 @@ int32_t UserActiveServlet::handle(sylar::http::HttpRequest::ptr request
         info->setState((int)State::PUBLISH);
         info->setUpdateTime(time(0));
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::UserInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "db update error");
-            SYLAR_LOG_ERROR(g_logger) << "user_data: " << info->toJsonString()
-                << " errno: " << db->getErrno()
-                << " errstr: " << db->getErrStr();
+            SYLAR_LOG_ERROR(g_logger) << "user_data: " << info->toJsonString();
             break;
         }
         SendWX("blog", "用户激活成功[" + auth_id + "]");
@@ -1,7 +1,9 @@
 #include "user_change_passwd_servlet.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include "blog/manager/user_manager.h"
+#include "blog/passwd_hasher.h"
 
 namespace blog {
 namespace servlet {
@@ -36,23 +38,26 @@ int32_t UserChangePasswdServlet::handle(sylar::http::HttpRequest::ptr request
             result->setResult(410, "code error");
             break;
         }
-        if(info->getPasswd() == passwd) {
+        bool need_rehash = false;
+        auto rt = PasswdHasherMgr::GetInstance()->verify(passwd, info->getPasswd()
+                        ,GetRemoteIP(request, session), need_rehash);
+        if(rt == PasswdHasher::BUSY) {
+            result->setResult(429, "too many requests");
+            break;
+        }
+        if(rt == PasswdHasher::OK) {
             result->setResult(410, "same passwd");
             break;
         }
-        info->setCode("");
-        info->setPasswd(passwd);
-        info->setUpdateTime(time(0));
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
+        std::string hashed;
+        if(!hashPasswd(request, session, result, passwd, hashed)) {
             break;
         }
-        if(data::UserInfoDao::Update(info, db)) {
+        info->setCode("");
+        info->setPasswd(hashed);
+        info->setUpdateTime(time(0));
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "db update error");
-
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
             break;
         }
         result->setResult(200, "ok");
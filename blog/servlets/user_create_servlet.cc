@@ -49,6 +49,11 @@ int32_t UserCreateServlet::handle(sylar::http::HttpRequest::ptr request
             break;
         }
 
+        std::string hashed;
+        if(!hashPasswd(request, session, result, passwd, hashed)) {
+            break;
+        }
+
         auto db = getDB();
         if(!db) {
             result->setResult(500, "get db error");
@@ -67,7 +72,7 @@ int32_t UserCreateServlet::handle(sylar::http::HttpRequest::ptr request
         data::UserInfo::ptr info(new data::UserInfo);
         info->setAccount(account);
         info->setEmail(email);
-        info->setPasswd(passwd);
+        info->setPasswd(hashed);
         info->setState((int)State::VERIFYING);
         info->setName(account);
         info->setCreateTime(time(0));
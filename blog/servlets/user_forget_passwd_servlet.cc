@@ -1,6 +1,7 @@
 #include "user_forget_passwd_servlet.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include "blog/manager/user_manager.h"
 #include "sylar/email/smtp.h"
 
@@ -50,13 +51,7 @@ int32_t UserForgetPasswdServlet::handle(sylar::http::HttpRequest::ptr request
 
         auto v = sylar::random_string(16);
         info->setCode(v);
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        //auto trans = db->openTransaction();
-        if(data::UserInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "db update error");
             break;
         }
@@ -80,7 +75,6 @@ int32_t UserForgetPasswdServlet::handle(sylar::http::HttpRequest::ptr request
             result->setResult(501, std::to_string(r->result) + " " + r->msg);
             break;
         }
-        //trans->commit();
         result->setResult(200, "ok");
     } while(false);
     response->setBody(result->toJsonString());
@@ -17,8 +17,7 @@ int32_t UserInfoServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,sylar::http::HttpSession::ptr session
                                   ,Result::ptr result) {
     do {
-        auto sdata = getSessionData(request, response);
-        int64_t uid = sdata->getData<int64_t>(CookieKey::USER_ID);
+        int64_t uid = getUserId(request);
         if(!uid) {
             result->setResult(410, "not login");
             break;
@@ -2,6 +2,8 @@
 #include "blog/util.h"
 #include "blog/struct.h"
 #include "blog/manager/user_manager.h"
+#include "blog/passwd_hasher.h"
+#include "blog/change_log.h"
 
 namespace blog {
 namespace servlet {
@@ -20,8 +22,7 @@ int32_t UserLoginServlet::handle(sylar::http::HttpRequest::ptr request
         DEFINE_AND_CHECK_STRING(result, auth_id, "auth_id");
         DEFINE_AND_CHECK_STRING(result, passwd, "passwd");
 
-        auto sdata = getSessionData(request, response);
-        if(sdata->getData<int64_t>(CookieKey::USER_ID)) {
+        if(initLogin(request, response, session)) {
             result->setResult(410, "already login");
             break;
         }
@@ -43,28 +44,33 @@ int32_t UserLoginServlet::handle(sylar::http::HttpRequest::ptr request
             result->setResult(410, "account invalid state");
             break;
         }
-        if(info->getPasswd() != passwd) {
-            SYLAR_LOG_INFO(g_logger) << "passwd: " << info->getPasswd()
-                << " - " << passwd << " - " << info->toJsonString();
-            result->setResult(410, "invalid passwd");
+        auto ip = GetRemoteIP(request, session);
+        bool need_rehash = false;
+        auto rt = PasswdHasherMgr::GetInstance()->verify(passwd, info->getPasswd()
+                        ,ip, need_rehash);
+        if(rt == PasswdHasher::BUSY) {
+            result->setResult(429, "too many requests");
             break;
         }
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
+        if(rt != PasswdHasher::OK) {
+            SYLAR_LOG_INFO(g_logger) << "invalid passwd uid=" << info->getId()
+                << " ip=" << ip << " rt=" << rt;
+            result->setResult(410, "invalid passwd");
             break;
         }
-        info->setLoginTime(time(0));
-        uint64_t ts1 = sylar::GetCurrentUS();
-        data::UserInfoDao::Update(info, db);
-        SYLAR_LOG_INFO(g_logger) << "update used: " << (sylar::GetCurrentUS() - ts1) / 1000.0 << " ms";
+        //旧格式密码登录成功后换成scrypt
+        std::string hashed;
+        if(need_rehash && PasswdHasherMgr::GetInstance()->hash(passwd, hashed, ip)
+                == PasswdHasher::OK) {
+            info->setPasswd(hashed);
+            info->setUpdateTime(time(0));
+            if(ChangeLogMgr::GetInstance()->update(info)) {
+                SYLAR_LOG_ERROR(g_logger) << "rehash passwd update fail uid=" << info->getId();
+            }
+        }
+        UserMgr::GetInstance()->touchLogin(info, time(0));
         result->setResult(200, "ok");
-        int64_t token_time = time(0) + 3600 * 24;
-        response->setCookie(CookieKey::USER_ID, std::to_string(info->getId()), token_time, "/");
-        auto token = UserManager::GetToken(info, token_time);
-        response->setCookie(CookieKey::TOKEN, token, token_time, "/");
-        response->setCookie(CookieKey::TOKEN_TIME, std::to_string(token_time), token_time, "/");
-        sdata->setData(CookieKey::USER_ID, info->getId());
+        setLoginCookie(request, response, info);
     } while(false);
     response->setBody(result->toJsonString());
     return 0;
@@ -17,19 +17,17 @@ int32_t UserLogoutServlet::handle(sylar::http::HttpRequest::ptr request
                                   ,sylar::http::HttpSession::ptr session
                                   ,Result::ptr result) {
     do {
-        auto sdata = getSessionData(request, response);
-        if(!sdata->getData<int64_t>(CookieKey::USER_ID)) {
+        if(!initLogin(request, response, session)) {
             result->setResult(410, "not login");
             break;
         }
 
         result->setResult(200, "ok");
-        int64_t token_time = time(0) - 3600 * 24;
-        response->setCookie(CookieKey::USER_ID, "", token_time, "/");
-        response->setCookie(CookieKey::TOKEN, "", token_time, "/");
-        response->setCookie(CookieKey::TOKEN_TIME, "", token_time, "/");
-        sdata->setData(CookieKey::USER_ID, (int64_t)0);
-        sylar::http::SessionDataMgr::GetInstance()->del(sdata->getId());
+        clearLoginCookie(response);
+        auto sid = getCookieId(request);
+        if(!sid.empty()) {
+            sylar::http::SessionDataMgr::GetInstance()->del(sid);
+        }
     } while(false);
     response->setBody(result->toJsonString());
     return 0;
@@ -1,6 +1,7 @@
 #include "user_update_servlet.h"
 #include "blog/util.h"
 #include "blog/struct.h"
+#include "blog/change_log.h"
 #include "blog/manager/user_manager.h"
 
 namespace blog {
@@ -25,8 +26,7 @@ int32_t UserUpdateServlet::handle(sylar::http::HttpRequest::ptr request
             break;
         }
 
-        auto sdata = getSessionData(request, response);
-        int64_t uid = sdata->getData<int64_t>(CookieKey::USER_ID);
+        int64_t uid = getUserId(request);
         if(!uid) {
             result->setResult(410, "not login");
             break;
@@ -38,33 +38,25 @@ int32_t UserUpdateServlet::handle(sylar::http::HttpRequest::ptr request
             break;
         }
 
+        std::string hashed;
+        if(!passwd.empty() && !hashPasswd(request, session, result, passwd, hashed)) {
+            break;
+        }
         if(!name.empty()) {
             info->setName(name);
         }
         if(!passwd.empty()) {
-            info->setPasswd(passwd);
+            info->setPasswd(hashed);
         }
 
-        auto db = getDB();
-        if(!db) {
-            result->setResult(500, "get db error");
-            break;
-        }
-        if(data::UserInfoDao::Update(info, db)) {
+        if(ChangeLogMgr::GetInstance()->update(info)) {
             result->setResult(500, "update user fail");
-            SYLAR_LOG_ERROR(g_logger) << "db error errno=" << db->getErrno()
-                << " errstr=" << db->getErrStr();
-            //TODO log
             break;
         }
         result->setResult(200, "ok");
 
         if(!passwd.empty()) {
-            int64_t token_time = time(0) + 3600 * 24;
-            response->setCookie(CookieKey::USER_ID, std::to_string(info->getId()), token_time, "/");
-            auto token = UserManager::GetToken(info, token_time);
-            response->setCookie(CookieKey::TOKEN, token, token_time, "/");
-            response->setCookie(CookieKey::TOKEN_TIME, std::to_string(token_time), token_time, "/");
+            setLoginCookie(request, response, info);
         }
     } while(false);
     response->setBody(result->toJsonString());
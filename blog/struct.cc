@@ -1,54 +1,81 @@
 #include "struct.h"
 #include "blog/manager/user_manager.h"
 #include "blog/util.h"
+#include "blog/json_writer.h"
+#include "blog/passwd_hasher.h"
+#include "blog/rate_limiter.h"
 #include "sylar/db/sqlite3.h"
+#include "sylar/worker.h"
+#include <set>
 
 namespace blog {
 
 static sylar::Logger::ptr g_logger_access = SYLAR_LOG_NAME("access");
 
+//本次请求解析出的uid, 请求开始时清空, 不信任客户端传入的值
+static const std::string s_uid_header = "X-Blog-Auth-Uid";
+
+static sylar::ConfigVar<uint32_t>::ptr g_gzip_min_size =
+    sylar::Config::Lookup("http.gzip.min_size", (uint32_t)1024, "http gzip min body size");
+//只有来自这些地址的连接才采信X-Real-IP, 代理需覆盖客户端传入的该头
+static sylar::ConfigVar<std::set<std::string> >::ptr g_trusted_proxies =
+    sylar::Config::Lookup("http.trusted_proxies", std::set<std::string>{"127.0.0.1"}
+            , "peer ips allowed to set X-Real-IP");
+
+static sylar::ConfigVar<uint32_t>::ptr g_gzip_offload_size =
+    sylar::Config::Lookup("http.gzip.offload_size", (uint32_t)(64 * 1024)
+            , "body size compressed in compress worker instead of io fiber");
+
 const std::string CookieKey::SESSION_KEY = "SSESSIONID";
 const std::string CookieKey::USER_ID = "S_UID";
 const std::string CookieKey::TOKEN = "S_TOKEN";
 const std::string CookieKey::TOKEN_TIME = "S_TOKEN_TIME";
 const std::string CookieKey::IS_AUTH= "IS_AUTH";
+const std::string CookieKey::SIGN_TOKEN = "S_SIGN";
 const std::string CookieKey::COMMENT_LAST_TIME = "COMMENT_LAST_TIME";
 const std::string CookieKey::ARTICLE_LAST_TIME = "ARTICLE_LAST_TIME";
 const std::string CookieKey::EMAIL_LAST_TIME = "EMAIL_LAST_TIME";
 
 std::string GetRemoteIP(sylar::http::HttpRequest::ptr request
                         ,sylar::http::HttpSession::ptr session) {
-    auto rt = request->getHeader("X-Real-IP");
-    if(!rt.empty()) {
-        return rt;
-    }
-    rt = session->getRemoteAddressString();
+    auto rt = session->getRemoteAddressString();
     auto pos = rt.find(':');
-    return rt.substr(0, pos);
+    rt = rt.substr(0, pos);
+    auto real = request->getHeader("X-Real-IP");
+    if(!real.empty() && g_trusted_proxies->getValue().count(rt)) {
+        return real;
+    }
+    return rt;
 }
 
 Result::Result(int32_t c, const std::string& m)
     :code(c)
     ,used(sylar::GetCurrentUS())
-    ,msg(m){
+    ,msg(m)
+    ,rawoffset(0) {
 }
 
 std::string Result::toJsonString() const {
-    Json::Value v;
-    v["code"] = std::to_string(code);
-    v["msg"] = msg;
-    v["used"] = ((sylar::GetCurrentUS() - used) / 1000.0);
-    if(!jsondata.isNull()) {
-        v["data"] = jsondata;
-    } else {
-        //if(!datas.empty()) {
-        //    auto& d = v["data"];
-        //    for(auto& i : datas) {
-        //        d[i.first] = i.second;
-        //    }
-        //}
+    std::string& buf = JsonWriter::Buffer();
+    JsonWriter w(buf);
+    char tmp[16];
+    int len = snprintf(tmp, sizeof(tmp), "%d", code);
+    w.startObject();
+    w.key("code");
+    w.value(tmp, len);
+    w.set("msg", msg);
+    w.set("used", ((sylar::GetCurrentUS() - used) / 1000.0));
+    rawoffset = 0;
+    if(!rawdata.empty()) {
+        w.key("data");
+        rawoffset = buf.size();
+        w.raw(rawdata);
+    } else if(!jsondata.isNull()) {
+        //直接遍历jsondata输出, 不再拷贝到外层DOM
+        w.set("data", jsondata);
     }
-    return sylar::JsonUtil::ToString(v);
+    w.endObject();
+    return buf;
 }
 
 void Result::setResult(int32_t c, const std::string& m) {
@@ -65,19 +92,172 @@ int32_t BlogServlet::handle(sylar::http::HttpRequest::ptr request
                            ,sylar::http::HttpSession::ptr session) {
     uint64_t ts = sylar::GetCurrentUS();
     Result::ptr result = std::make_shared<Result>();
+    request->setHeader(s_uid_header, "");
     response->setHeader("Access-Control-Allow-Origin", "*");
     response->setHeader("Access-Control-Allow-Credentials", "true");
     if(handlePre(request, response, session, result)) {
-        handle(request, response, session, result);
+        if(!checkNotModified(request, response, result)) {
+            handle(request, response, session, result);
+        }
     } else {
         response->setBody(result->toJsonString());
     }
+    encode(request, response, result);
     uint64_t used = sylar::GetCurrentUS() - ts;
     handlePost(request, response, session, result);
     response->setHeader("used", std::to_string((used * 1.0 / 1000)) + "ms");
     return 0;
 }
 
+static bool AcceptGzip(const std::string& str) {
+    auto parts = sylar::split(str, ',');
+    for(auto& i : parts) {
+        auto tmp = sylar::split(i, ';');
+        auto name = sylar::StringUtil::Trim(tmp[0]);
+        if(name != "gzip" && name != "*") {
+            continue;
+        }
+        bool refuse = false;
+        for(size_t n = 1; n < tmp.size(); ++n) {
+            auto q = sylar::StringUtil::Trim(tmp[n]);
+            if(q.size() > 2 && q.substr(0, 2) == "q="
+                    && atof(q.c_str() + 2) <= 0) {
+                refuse = true;
+            }
+        }
+        return !refuse;
+    }
+    return false;
+}
+
+static std::string GzipBody(const std::string& body, Result::ptr result) {
+    GzipBuilder gz;
+    size_t pos = 0;
+    if(result->rawoffset) {
+        for(auto& i : result->pieces) {
+            size_t off = result->rawoffset + i.first;
+            if(off < pos || off + i.second->len > body.size()) {
+                break;
+            }
+            if(!gz.add(body.c_str() + pos, off - pos)) {
+                return "";
+            }
+            gz.add(*i.second);
+            pos = off + i.second->len;
+        }
+    }
+    if(!gz.add(body.c_str() + pos, body.size() - pos)) {
+        return "";
+    }
+    return gz.finish();
+}
+
+void BlogServlet::encode(sylar::http::HttpRequest::ptr request
+                        ,sylar::http::HttpResponse::ptr response
+                        ,Result::ptr result) {
+    const std::string& body = response->getBody();
+    if(body.size() < g_gzip_min_size->getValue()
+            || !response->getHeader("Content-Encoding").empty()
+            || !AcceptGzip(request->getHeader("Accept-Encoding"))) {
+        return;
+    }
+    std::string out;
+    auto cb = [&out, &body, result]() {
+        out = GzipBody(body, result);
+    };
+    //大响应放到compress线程压缩, 避免阻塞io协程
+    auto worker = sylar::WorkerMgr::GetInstance()->get("compress");
+    if(worker && body.size() >= g_gzip_offload_size->getValue()) {
+        auto wg = sylar::WorkerGroup::Create(1, worker.get());
+        wg->schedule(cb);
+        wg->waitAll();
+    } else {
+        cb();
+    }
+    if(out.empty() || out.size() >= body.size()) {
+        return;
+    }
+    response->setBody(out);
+    response->setHeader("Content-Encoding", "gzip");
+    auto vary = response->getHeader("Vary");
+    response->setHeader("Vary", vary.empty() ? "Accept-Encoding" : vary + ", Accept-Encoding");
+    //压缩后字节不同, 强etag需要区分编码
+    auto etag = response->getHeader("ETag");
+    if(etag.size() > 2) {
+        response->setHeader("ETag", etag.substr(0, etag.size() - 1) + "-gz\"");
+    }
+}
+
+std::string HashETag(const std::string& key) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%016llx"
+            ,(unsigned long long)sylar::murmur3_hash64(key.c_str()));
+    return buf;
+}
+
+static std::string HttpDate(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+bool BlogServlet::getETag(sylar::http::HttpRequest::ptr request
+                         ,std::string& etag, time_t& last_modified, bool& personal) {
+    return false;
+}
+
+bool BlogServlet::checkNotModified(sylar::http::HttpRequest::ptr request
+                                   ,sylar::http::HttpResponse::ptr response
+                                   ,Result::ptr result) {
+    if(request->getMethod() != sylar::http::HttpMethod::GET) {
+        return false;
+    }
+    std::string etag;
+    time_t last_modified = 0;
+    bool personal = false;
+    if(!getETag(request, etag, last_modified, personal)) {
+        return false;
+    }
+    if(personal) {
+        response->setHeader("Cache-Control", "private");
+        response->setHeader("Vary", "Cookie");
+    }
+    std::string tag = "\"" + etag + "\"";
+    std::string gz_tag = "\"" + etag + "-gz\"";
+    response->setHeader("ETag", tag);
+    std::string lm;
+    if(last_modified) {
+        lm = HttpDate(last_modified);
+        response->setHeader("Last-Modified", lm);
+    }
+
+    bool match = false;
+    auto inm = request->getHeader("If-None-Match");
+    if(!inm.empty()) {
+        auto parts = sylar::split(inm, ',');
+        for(auto& i : parts) {
+            auto t = sylar::StringUtil::Trim(i);
+            if(t == "*" || t == tag || t == gz_tag) {
+                if(t == gz_tag) {
+                    response->setHeader("ETag", gz_tag);
+                }
+                match = true;
+                break;
+            }
+        }
+    } else if(!lm.empty()) {
+        match = request->getHeader("If-Modified-Since") == lm;
+    }
+    if(!match) {
+        return false;
+    }
+    response->setStatus(sylar::http::HttpStatus::NOT_MODIFIED);
+    result->setResult(304, "not modified");
+    return true;
+}
+
 bool BlogServlet::handlePre(sylar::http::HttpRequest::ptr request
                            ,sylar::http::HttpResponse::ptr response
                            ,sylar::http::HttpSession::ptr session
@@ -91,6 +271,20 @@ bool BlogServlet::handlePre(sylar::http::HttpRequest::ptr request
         result->setResult(300, "invalid method");
         return false;
     }
+    return checkRateLimit(request, response, session, result);
+}
+
+bool BlogServlet::checkRateLimit(sylar::http::HttpRequest::ptr request
+                                 ,sylar::http::HttpResponse::ptr response
+                                 ,sylar::http::HttpSession::ptr session
+                                 ,Result::ptr result) {
+    uint32_t retry_after = 0;
+    if(!RateLimiterMgr::GetInstance()->check(request->getPath()
+                ,GetRemoteIP(request, session), getUserId(request), retry_after)) {
+        response->setHeader("Retry-After", std::to_string(retry_after));
+        result->setResult(429, "too many requests");
+        return false;
+    }
     return true;
 }
 
@@ -127,21 +321,47 @@ sylar::http::SessionData::ptr BlogServlet::getSessionData(sylar::http::HttpReque
 bool BlogServlet::initLogin(sylar::http::HttpRequest::ptr request
                            ,sylar::http::HttpResponse::ptr response
                            ,sylar::http::HttpSession::ptr session) {
-    auto data = getSessionData(request, response);
-    int64_t uid = data->getData<int64_t>(CookieKey::USER_ID);
-    if(uid) {
-        return true;
+    auto v = request->getHeader(s_uid_header);
+    if(!v.empty()) {
+        return sylar::TypeUtil::Atoi(v) != 0;
     }
-    int32_t is_auth = data->getData<int32_t>(CookieKey::IS_AUTH);
-    if(is_auth) {
-        return false;
+    int64_t uid = authenticate(request, response, session);
+    request->setHeader(s_uid_header, std::to_string(uid));
+    return uid != 0;
+}
+
+int64_t BlogServlet::authenticate(sylar::http::HttpRequest::ptr request
+                                  ,sylar::http::HttpResponse::ptr response
+                                  ,sylar::http::HttpSession::ptr session) {
+    auto sign = request->getCookie(CookieKey::SIGN_TOKEN);
+    if(!sign.empty()) {
+        int64_t uid = UserManager::VerifySignToken(sign);
+        if(uid) {
+            return uid;
+        }
     }
-    bool is_login = false;
-    do {
-        int64_t uid = request->getCookieAs<int64_t>(CookieKey::USER_ID);
-        if(!uid) {
-            break;
+    //兼容已有会话, 只查不建, 匿名请求不再创建会话
+    std::string sid = request->getCookie(CookieKey::SESSION_KEY);
+    if(!sid.empty()) {
+        auto data = sylar::http::SessionDataMgr::GetInstance()->get(sid);
+        if(data) {
+            int64_t uid = data->getData<int64_t>(CookieKey::USER_ID);
+            if(uid) {
+                return uid;
+            }
         }
+    }
+    return autoLogin(request, response, session);
+}
+
+int64_t BlogServlet::autoLogin(sylar::http::HttpRequest::ptr request
+                               ,sylar::http::HttpResponse::ptr response
+                               ,sylar::http::HttpSession::ptr session) {
+    int64_t uid = request->getCookieAs<int64_t>(CookieKey::USER_ID);
+    if(!uid) {
+        return 0;
+    }
+    do {
         auto token = request->getCookie(CookieKey::TOKEN);
         if(token.empty()) {
             break;
@@ -169,8 +389,6 @@ bool BlogServlet::initLogin(sylar::http::HttpRequest::ptr request
                 << "\t" << (!request->getQuery().empty() ? request->getQuery() : "-");
             break;
         }
-        data->setData(CookieKey::USER_ID, uid);
-        is_login = true;
         SYLAR_LOG_INFO(g_logger_access)
             << GetRemoteIP(request, session) << "\t"
             << request->getCookie(CookieKey::SESSION_KEY, "-") << "\t"
@@ -179,15 +397,52 @@ bool BlogServlet::initLogin(sylar::http::HttpRequest::ptr request
             << "ok" << "\tauto_login" << request->getPath()
             << "\t" << (!request->getQuery().empty() ? request->getQuery() : "-");
 
-        uinfo->setLoginTime(time(0));
-        auto db = getDB();
-        if(db) {
-            data::UserInfoDao::Update(uinfo, db);
-        }
-        is_login = true;
+        UserMgr::GetInstance()->touchLogin(uinfo, time(0));
+        //旧令牌换成签名令牌, 之后的请求不再走这里
+        setLoginCookie(request, response, uinfo);
+        return uid;
     } while(0);
-    data->setData(CookieKey::IS_AUTH, (int32_t)1);
-    return is_login;
+    //旧令牌无效, 清掉避免每个请求重复校验
+    clearLoginCookie(response);
+    return 0;
+}
+
+void BlogServlet::setLoginCookie(sylar::http::HttpRequest::ptr request
+                                 ,sylar::http::HttpResponse::ptr response
+                                 ,data::UserInfo::ptr info) {
+    int64_t token_time = time(0) + 3600 * 24;
+    response->setCookie(CookieKey::SIGN_TOKEN
+            ,UserManager::GetSignToken(info, token_time), token_time, "/");
+    //旧令牌不再下发, 清掉已有的
+    int64_t expired = time(0) - 3600 * 24;
+    response->setCookie(CookieKey::USER_ID, "", expired, "/");
+    response->setCookie(CookieKey::TOKEN, "", expired, "/");
+    response->setCookie(CookieKey::TOKEN_TIME, "", expired, "/");
+}
+
+void BlogServlet::clearLoginCookie(sylar::http::HttpResponse::ptr response) {
+    int64_t expired = time(0) - 3600 * 24;
+    response->setCookie(CookieKey::SIGN_TOKEN, "", expired, "/");
+    response->setCookie(CookieKey::USER_ID, "", expired, "/");
+    response->setCookie(CookieKey::TOKEN, "", expired, "/");
+    response->setCookie(CookieKey::TOKEN_TIME, "", expired, "/");
+}
+
+bool BlogServlet::hashPasswd(sylar::http::HttpRequest::ptr request
+                            ,sylar::http::HttpSession::ptr session
+                            ,Result::ptr result
+                            ,const std::string& passwd, std::string& out) {
+    auto rt = PasswdHasherMgr::GetInstance()->hash(passwd, out
+                    ,GetRemoteIP(request, session));
+    if(rt == PasswdHasher::BUSY) {
+        result->setResult(429, "too many requests");
+        return false;
+    }
+    if(rt != PasswdHasher::OK) {
+        result->setResult(500, "hash passwd fail");
+        return false;
+    }
+    return true;
 }
 
 sylar::IDB::ptr BlogServlet::getDB() {
@@ -211,18 +466,11 @@ bool BlogLoginedServlet::handlePre(sylar::http::HttpRequest::ptr request
         result->setResult(300, "invalid method");
         return false;
     }
-    return true;
+    return checkRateLimit(request, response, session, result);
 }
 
 int64_t BlogServlet::getUserId(sylar::http::HttpRequest::ptr request) {
-    std::string sid = request->getCookie(CookieKey::SESSION_KEY);
-    if(!sid.empty()) {
-        auto data = sylar::http::SessionDataMgr::GetInstance()->get(sid);
-        if(data) {
-            return data->getData<int64_t>(CookieKey::USER_ID);
-        }
-    }
-    return 0;
+    return sylar::TypeUtil::Atoi(request->getHeader(s_uid_header));
 }
 
 std::string BlogServlet::getCookieId(sylar::http::HttpRequest::ptr request) {
@@ -7,6 +7,8 @@
 #include "sylar/http/session_data.h"
 #include "sylar/db/db.h"
 #include "sylar/sylar.h"
+#include "blog/gzip.h"
+#include "blog/data/user_info.h"
 
 namespace blog {
 
@@ -25,6 +27,12 @@ struct Result {
     std::string msg;
     //std::map<std::string, std::string> datas;
     Json::Value jsondata;
+    //已序列化的data, 非空时代替jsondata输出
+    std::string rawdata;
+    //rawdata中已预压缩的片段(偏移, gzip片段), 压缩响应时直接拼接
+    std::vector<std::pair<size_t, GzipPiece::ptr> > pieces;
+    //rawdata在toJsonString结果中的偏移
+    mutable size_t rawoffset;
 
     template<class T>
     void set(const std::string& key, const T& v) {
@@ -54,6 +62,7 @@ struct CookieKey {
     static const std::string TOKEN;
     static const std::string TOKEN_TIME;
     static const std::string IS_AUTH;
+    static const std::string SIGN_TOKEN;
 
     static const std::string COMMENT_LAST_TIME;
     static const std::string ARTICLE_LAST_TIME;
@@ -82,16 +91,56 @@ protected:
                            ,sylar::http::HttpResponse::ptr response
                            ,sylar::http::HttpSession::ptr session
                            ,Result::ptr result);
+    //支持条件请求的servlet返回true, 填写etag(不含引号)和last_modified(0表示不输出)
+    //last_modified须为etag所有输入中最新的修改时间, 含无时间的输入(如计数)时填0
+    //etag依赖登录用户时置personal, 响应不允许共享缓存
+    virtual bool getETag(sylar::http::HttpRequest::ptr request
+                         ,std::string& etag, time_t& last_modified, bool& personal);
 protected:
     sylar::http::SessionData::ptr getSessionData(sylar::http::HttpRequest::ptr request
                                                  ,sylar::http::HttpResponse::ptr response);
+    //每个请求只解析一次登录态, 结果记录在请求上供getUserId读取
     bool initLogin(sylar::http::HttpRequest::ptr request
                    ,sylar::http::HttpResponse::ptr response
                    ,sylar::http::HttpSession::ptr session);
+    void setLoginCookie(sylar::http::HttpRequest::ptr request
+                        ,sylar::http::HttpResponse::ptr response
+                        ,data::UserInfo::ptr info);
+    void clearLoginCookie(sylar::http::HttpResponse::ptr response);
+    //按rate_limit.rules限流, 在登录态解析后调用, 超限时已设置result和Retry-After
+    bool checkRateLimit(sylar::http::HttpRequest::ptr request
+                        ,sylar::http::HttpResponse::ptr response
+                        ,sylar::http::HttpSession::ptr session
+                        ,Result::ptr result);
+    //在passwd线程池中哈希密码, 失败时已设置result
+    bool hashPasswd(sylar::http::HttpRequest::ptr request
+                    ,sylar::http::HttpSession::ptr session
+                    ,Result::ptr result
+                    ,const std::string& passwd, std::string& out);
 protected:
     sylar::IDB::ptr getDB();
+private:
+    int64_t authenticate(sylar::http::HttpRequest::ptr request
+                         ,sylar::http::HttpResponse::ptr response
+                         ,sylar::http::HttpSession::ptr session);
+    int64_t autoLogin(sylar::http::HttpRequest::ptr request
+                      ,sylar::http::HttpResponse::ptr response
+                      ,sylar::http::HttpSession::ptr session);
+    bool checkNotModified(sylar::http::HttpRequest::ptr request
+                          ,sylar::http::HttpResponse::ptr response
+                          ,Result::ptr result);
+    void encode(sylar::http::HttpRequest::ptr request
+                ,sylar::http::HttpResponse::ptr response
+                ,Result::ptr result);
 };
 
+//连接来自http.trusted_proxies中的代理时取X-Real-IP, 否则取连接地址
+std::string GetRemoteIP(sylar::http::HttpRequest::ptr request
+                        ,sylar::http::HttpSession::ptr session);
+
+//由实体版本等拼成的key生成etag
+std::string HashETag(const std::string& key);
+
 class BlogLoginedServlet : public BlogServlet {
 public:
     BlogLoginedServlet(const std::string& name);
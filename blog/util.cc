@@ -2,6 +2,7 @@
 #include <regex>
 #include "sylar/sylar.h"
 #include "sylar/config.h"
+#include "blog/db_pool.h"
 
 namespace blog {
 
@@ -19,11 +20,42 @@ bool is_valid_account(const std::string& str) {
 }
 
 sylar::IDB::ptr GetDB() {
+    return DBRouterMgr::GetInstance()->getWrite();
+}
+
+sylar::IDB::ptr GetReadDB() {
+    return DBRouterMgr::GetInstance()->getRead();
+}
+
+sylar::IDB::ptr GetRawDB(const std::string& name) {
     if(g_db_type->getValue() == 2) {
-        return sylar::MySQLMgr::GetInstance()->get("blog");
+        return sylar::MySQLMgr::GetInstance()->get(name);
     } else {
-        return sylar::SQLite3Mgr::GetInstance()->get("blog");
+        return sylar::SQLite3Mgr::GetInstance()->get(name);
+    }
+}
+
+bool EnsureIndex(sylar::IDB::ptr db, const std::string& table
+                 ,const std::string& name, const std::string& cols) {
+    if(!db) {
+        return false;
+    }
+    if(g_db_type->getValue() != 2) {
+        return db->execute("create index if not exists " + name
+                    + " on " + table + "(" + cols + ")") == 0;
+    }
+    //mysql不支持create index if not exists, 先查information_schema
+    auto rt = db->query("select count(*) from information_schema.statistics"
+                " where table_schema = database() and table_name = '%s' and index_name = '%s'"
+                ,table.c_str(), name.c_str());
+    if(!rt || !rt->next()) {
+        return false;
+    }
+    if(rt->getInt64(0) > 0) {
+        return true;
     }
+    return db->execute("alter table `" + table + "` add index `" + name
+                + "` (" + cols + ")") == 0;
 }
 
 std::string get_max_length_string(const std::string& str, size_t len) {
@@ -8,7 +8,15 @@ namespace blog {
 
 bool is_email(const std::string& str);
 bool is_valid_account(const std::string& str);
+//写连接, 走主库
 sylar::IDB::ptr GetDB();
+//读连接, 优先走延迟可接受的副本, 用于批量加载等可容忍短暂滞后的读
+sylar::IDB::ptr GetReadDB();
+//不经过连接池, 直接从sylar的mysql/sqlite3管理器获取连接
+sylar::IDB::ptr GetRawDB(const std::string& name = "blog");
+//老库补建orm_config中后加的索引, 按db.type使用对应方言, 已存在时不做处理
+bool EnsureIndex(sylar::IDB::ptr db, const std::string& table
+                 ,const std::string& name, const std::string& cols);
 
 #define DEFINE_AND_CHECK_STRING(result, var, param) \
     std::string var = request->getParam(param); \
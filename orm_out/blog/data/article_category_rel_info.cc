@@ -108,6 +108,89 @@ int ArticleCategoryRelInfoDao::InsertOrUpdate(ArticleCategoryRelInfo::ptr info,
     return stmt->execute();
 }
 
+int ArticleCategoryRelInfoDao::InsertMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into article_category_rel (article_id, category_id, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 5;
+            stmt->bindInt64(idx + 1, info->m_articleId);
+            stmt->bindInt64(idx + 2, info->m_categoryId);
+            stmt->bindInt32(idx + 3, info->m_isDeleted);
+            stmt->bindTime(idx + 4, info->m_createTime);
+            stmt->bindTime(idx + 5, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ArticleCategoryRelInfoDao::UpdateMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ArticleCategoryRelInfoDao::UpsertMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into article_category_rel (id, article_id, category_id, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 6;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindInt64(idx + 2, info->m_articleId);
+            stmt->bindInt64(idx + 3, info->m_categoryId);
+            stmt->bindInt32(idx + 4, info->m_isDeleted);
+            stmt->bindTime(idx + 5, info->m_createTime);
+            stmt->bindTime(idx + 6, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int ArticleCategoryRelInfoDao::Delete(ArticleCategoryRelInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from article_category_rel where id = ?";
     auto stmt = conn->prepare(sql);
@@ -182,6 +265,58 @@ int ArticleCategoryRelInfoDao::QueryAll(std::vector<ArticleCategoryRelInfo::ptr>
     return 0;
 }
 
+int ArticleCategoryRelInfoDao::QueryAll(std::function<void(ArticleCategoryRelInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, article_id, category_id, is_deleted, create_time, update_time from article_category_rel";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleCategoryRelInfo::ptr v(new ArticleCategoryRelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_articleId = rt->getInt64(1);
+        v->m_categoryId = rt->getInt64(2);
+        v->m_isDeleted = rt->getInt32(3);
+        v->m_createTime = rt->getTime(4);
+        v->m_updateTime = rt->getTime(5);
+        cb(v);
+    }
+    return 0;
+}
+
+int ArticleCategoryRelInfoDao::QueryByIdRange(std::function<void(ArticleCategoryRelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, article_id, category_id, is_deleted, create_time, update_time from article_category_rel where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleCategoryRelInfo::ptr v(new ArticleCategoryRelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_articleId = rt->getInt64(1);
+        v->m_categoryId = rt->getInt64(2);
+        v->m_isDeleted = rt->getInt32(3);
+        v->m_createTime = rt->getTime(4);
+        v->m_updateTime = rt->getTime(5);
+        cb(v);
+    }
+    return 0;
+}
+
 ArticleCategoryRelInfo::ptr ArticleCategoryRelInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, article_id, category_id, is_deleted, create_time, update_time from article_category_rel where id = ?";
     auto stmt = conn->prepare(sql);
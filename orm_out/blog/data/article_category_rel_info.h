@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -54,12 +55,17 @@ public:
     static int Update(ArticleCategoryRelInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(ArticleCategoryRelInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(ArticleCategoryRelInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<ArticleCategoryRelInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(ArticleCategoryRelInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteByArticleId( const int64_t& article_id, sylar::IDB::ptr conn);
     static int DeleteByArticleIdCategoryId( const int64_t& article_id,  const int64_t& category_id, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<ArticleCategoryRelInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(ArticleCategoryRelInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(ArticleCategoryRelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static ArticleCategoryRelInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryByArticleId(std::vector<ArticleCategoryRelInfo::ptr>& results,  const int64_t& article_id, sylar::IDB::ptr conn);
     static ArticleCategoryRelInfo::ptr QueryByArticleIdCategoryId( const int64_t& article_id,  const int64_t& category_id, sylar::IDB::ptr conn);
@@ -131,6 +131,44 @@ int ArticleInfoDao::Update(ArticleInfo::ptr info, sylar::IDB::ptr conn) {
     return stmt->execute();
 }
 
+int ArticleInfoDao::UpdateMeta(ArticleInfo::ptr info, sylar::IDB::ptr conn) {
+    std::string sql = "update article set user_id = ?, title = ?, type = ?, state = ?, channel = ?, is_deleted = ?, publish_time = ?, weight = ?, views = ?, praise = ?, favorites = ?, create_time = ?, update_time = ? where id = ?";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, info->m_userId);
+    stmt->bindString(2, info->m_title);
+    stmt->bindInt32(3, info->m_type);
+    stmt->bindInt32(4, info->m_state);
+    stmt->bindInt64(5, info->m_channel);
+    stmt->bindInt32(6, info->m_isDeleted);
+    stmt->bindTime(7, info->m_publishTime);
+    stmt->bindInt64(8, info->m_weight);
+    stmt->bindInt64(9, info->m_views);
+    stmt->bindInt64(10, info->m_praise);
+    stmt->bindInt64(11, info->m_favorites);
+    stmt->bindTime(12, info->m_createTime);
+    stmt->bindTime(13, info->m_updateTime);
+    stmt->bindInt64(14, info->m_id);
+    return stmt->execute();
+}
+
+int ArticleInfoDao::UpdateContent( const int64_t& id,  const std::string& content, sylar::IDB::ptr conn) {
+    std::string sql = "update article set content = ? where id = ?";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindString(1, content);
+    stmt->bindInt64(2, id);
+    return stmt->execute();
+}
+
 int ArticleInfoDao::Insert(ArticleInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "insert into article (user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
     auto stmt = conn->prepare(sql);
@@ -189,6 +227,107 @@ int ArticleInfoDao::InsertOrUpdate(ArticleInfo::ptr info, sylar::IDB::ptr conn)
     return stmt->execute();
 }
 
+int ArticleInfoDao::InsertMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into article (user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 14;
+            stmt->bindInt64(idx + 1, info->m_userId);
+            stmt->bindString(idx + 2, info->m_title);
+            stmt->bindString(idx + 3, info->m_content);
+            stmt->bindInt32(idx + 4, info->m_type);
+            stmt->bindInt32(idx + 5, info->m_state);
+            stmt->bindInt64(idx + 6, info->m_channel);
+            stmt->bindInt32(idx + 7, info->m_isDeleted);
+            stmt->bindTime(idx + 8, info->m_publishTime);
+            stmt->bindInt64(idx + 9, info->m_weight);
+            stmt->bindInt64(idx + 10, info->m_views);
+            stmt->bindInt64(idx + 11, info->m_praise);
+            stmt->bindInt64(idx + 12, info->m_favorites);
+            stmt->bindTime(idx + 13, info->m_createTime);
+            stmt->bindTime(idx + 14, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ArticleInfoDao::UpdateMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ArticleInfoDao::UpsertMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into article (id, user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 15;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindInt64(idx + 2, info->m_userId);
+            stmt->bindString(idx + 3, info->m_title);
+            stmt->bindString(idx + 4, info->m_content);
+            stmt->bindInt32(idx + 5, info->m_type);
+            stmt->bindInt32(idx + 6, info->m_state);
+            stmt->bindInt64(idx + 7, info->m_channel);
+            stmt->bindInt32(idx + 8, info->m_isDeleted);
+            stmt->bindTime(idx + 9, info->m_publishTime);
+            stmt->bindInt64(idx + 10, info->m_weight);
+            stmt->bindInt64(idx + 11, info->m_views);
+            stmt->bindInt64(idx + 12, info->m_praise);
+            stmt->bindInt64(idx + 13, info->m_favorites);
+            stmt->bindTime(idx + 14, info->m_createTime);
+            stmt->bindTime(idx + 15, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int ArticleInfoDao::Delete(ArticleInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from article where id = ?";
     auto stmt = conn->prepare(sql);
@@ -259,6 +398,181 @@ int ArticleInfoDao::QueryAll(std::vector<ArticleInfo::ptr>& results, sylar::IDB:
     return 0;
 }
 
+int ArticleInfoDao::QueryAll(std::function<void(ArticleInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleInfo::ptr v(new ArticleInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_title = rt->getString(2);
+        v->m_content = rt->getString(3);
+        v->m_type = rt->getInt32(4);
+        v->m_state = rt->getInt32(5);
+        v->m_channel = rt->getInt64(6);
+        v->m_isDeleted = rt->getInt32(7);
+        v->m_publishTime = rt->getTime(8);
+        v->m_weight = rt->getInt64(9);
+        v->m_views = rt->getInt64(10);
+        v->m_praise = rt->getInt64(11);
+        v->m_favorites = rt->getInt64(12);
+        v->m_createTime = rt->getTime(13);
+        v->m_updateTime = rt->getTime(14);
+        cb(v);
+    }
+    return 0;
+}
+
+int ArticleInfoDao::QueryByIdRange(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleInfo::ptr v(new ArticleInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_title = rt->getString(2);
+        v->m_content = rt->getString(3);
+        v->m_type = rt->getInt32(4);
+        v->m_state = rt->getInt32(5);
+        v->m_channel = rt->getInt64(6);
+        v->m_isDeleted = rt->getInt32(7);
+        v->m_publishTime = rt->getTime(8);
+        v->m_weight = rt->getInt64(9);
+        v->m_views = rt->getInt64(10);
+        v->m_praise = rt->getInt64(11);
+        v->m_favorites = rt->getInt64(12);
+        v->m_createTime = rt->getTime(13);
+        v->m_updateTime = rt->getTime(14);
+        cb(v);
+    }
+    return 0;
+}
+
+int ArticleInfoDao::QueryAllMeta(std::function<void(ArticleInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, title, substr(content, 1, 100), type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleInfo::ptr v(new ArticleInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_title = rt->getString(2);
+        v->m_content = rt->getString(3);
+        v->m_type = rt->getInt32(4);
+        v->m_state = rt->getInt32(5);
+        v->m_channel = rt->getInt64(6);
+        v->m_isDeleted = rt->getInt32(7);
+        v->m_publishTime = rt->getTime(8);
+        v->m_weight = rt->getInt64(9);
+        v->m_views = rt->getInt64(10);
+        v->m_praise = rt->getInt64(11);
+        v->m_favorites = rt->getInt64(12);
+        v->m_createTime = rt->getTime(13);
+        v->m_updateTime = rt->getTime(14);
+        cb(v);
+    }
+    return 0;
+}
+
+int ArticleInfoDao::QueryMetaByIdRange(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, title, substr(content, 1, 100), type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleInfo::ptr v(new ArticleInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_title = rt->getString(2);
+        v->m_content = rt->getString(3);
+        v->m_type = rt->getInt32(4);
+        v->m_state = rt->getInt32(5);
+        v->m_channel = rt->getInt64(6);
+        v->m_isDeleted = rt->getInt32(7);
+        v->m_publishTime = rt->getTime(8);
+        v->m_weight = rt->getInt64(9);
+        v->m_views = rt->getInt64(10);
+        v->m_praise = rt->getInt64(11);
+        v->m_favorites = rt->getInt64(12);
+        v->m_createTime = rt->getTime(13);
+        v->m_updateTime = rt->getTime(14);
+        cb(v);
+    }
+    return 0;
+}
+
+int ArticleInfoDao::QueryUpdatedSince(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& update_time, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article where update_time >= ?";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindTime(1, update_time);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ArticleInfo::ptr v(new ArticleInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_title = rt->getString(2);
+        v->m_content = rt->getString(3);
+        v->m_type = rt->getInt32(4);
+        v->m_state = rt->getInt32(5);
+        v->m_channel = rt->getInt64(6);
+        v->m_isDeleted = rt->getInt32(7);
+        v->m_publishTime = rt->getTime(8);
+        v->m_weight = rt->getInt64(9);
+        v->m_views = rt->getInt64(10);
+        v->m_praise = rt->getInt64(11);
+        v->m_favorites = rt->getInt64(12);
+        v->m_createTime = rt->getTime(13);
+        v->m_updateTime = rt->getTime(14);
+        cb(v);
+    }
+    return 0;
+}
+
 ArticleInfo::ptr ArticleInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, user_id, title, content, type, state, channel, is_deleted, publish_time, weight, views, praise, favorites, create_time, update_time from article where id = ?";
     auto stmt = conn->prepare(sql);
@@ -347,6 +661,7 @@ int ArticleInfoDao::CreateTableSQLite3(sylar::IDB::ptr conn) {
             "create_time TIMESTAMP NOT NULL DEFAULT '1980-01-01 00:00:00',"
             "update_time TIMESTAMP NOT NULL DEFAULT '1980-01-01 00:00:00');"
             "CREATE INDEX article_user_id ON article(user_id);"
+            "CREATE INDEX article_update_time ON article(update_time);"
             );
 }
 
@@ -368,7 +683,8 @@ int ArticleInfoDao::CreateTableMySQL(sylar::IDB::ptr conn) {
             "`create_time` timestamp NOT NULL DEFAULT '1980-01-01 00:00:00' COMMENT '创建时间',"
             "`update_time` timestamp NOT NULL DEFAULT '1980-01-01 00:00:00' ON UPDATE current_timestamp  COMMENT '更新时间',"
             "PRIMARY KEY(`id`),"
-            "KEY `article_user_id` (`user_id`)) COMMENT='博客文章'");
+            "KEY `article_user_id` (`user_id`),"
+            "KEY `article_update_time` (`update_time`)) COMMENT='博客文章'");
 }
 } //namespace data
 } //namespace blog
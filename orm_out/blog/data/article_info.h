@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -88,13 +89,23 @@ class ArticleInfoDao {
 public:
     typedef std::shared_ptr<ArticleInfoDao> ptr;
     static int Update(ArticleInfo::ptr info, sylar::IDB::ptr conn);
+    static int UpdateMeta(ArticleInfo::ptr info, sylar::IDB::ptr conn);
+    static int UpdateContent( const int64_t& id,  const std::string& content, sylar::IDB::ptr conn);
     static int Insert(ArticleInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(ArticleInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<ArticleInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(ArticleInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteByUserId( const int64_t& user_id, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<ArticleInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(ArticleInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
+    static int QueryAllMeta(std::function<void(ArticleInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryMetaByIdRange(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
+    static int QueryUpdatedSince(std::function<void(ArticleInfo::ptr)> cb,  const int64_t& update_time, sylar::IDB::ptr conn);
     static ArticleInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryByUserId(std::vector<ArticleInfo::ptr>& results,  const int64_t& user_id, sylar::IDB::ptr conn);
     static int CreateTableSQLite3(sylar::IDB::ptr info);
@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -54,12 +55,17 @@ public:
     static int Update(ArticleLabelRelInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(ArticleLabelRelInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(ArticleLabelRelInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<ArticleLabelRelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<ArticleLabelRelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<ArticleLabelRelInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(ArticleLabelRelInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteByArticleId( const int64_t& article_id, sylar::IDB::ptr conn);
     static int DeleteByArticleIdLabelId( const int64_t& article_id,  const int64_t& label_id, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<ArticleLabelRelInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(ArticleLabelRelInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(ArticleLabelRelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static ArticleLabelRelInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryByArticleId(std::vector<ArticleLabelRelInfo::ptr>& results,  const int64_t& article_id, sylar::IDB::ptr conn);
     static ArticleLabelRelInfo::ptr QueryByArticleIdLabelId( const int64_t& article_id,  const int64_t& label_id, sylar::IDB::ptr conn);
@@ -117,6 +117,91 @@ int CategoryInfoDao::InsertOrUpdate(CategoryInfo::ptr info, sylar::IDB::ptr conn
     return stmt->execute();
 }
 
+int CategoryInfoDao::InsertMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into category (user_id, name, parent_id, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 6;
+            stmt->bindInt64(idx + 1, info->m_userId);
+            stmt->bindString(idx + 2, info->m_name);
+            stmt->bindInt64(idx + 3, info->m_parentId);
+            stmt->bindInt32(idx + 4, info->m_isDeleted);
+            stmt->bindTime(idx + 5, info->m_createTime);
+            stmt->bindTime(idx + 6, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int CategoryInfoDao::UpdateMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int CategoryInfoDao::UpsertMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into category (id, user_id, name, parent_id, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 7;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindInt64(idx + 2, info->m_userId);
+            stmt->bindString(idx + 3, info->m_name);
+            stmt->bindInt64(idx + 4, info->m_parentId);
+            stmt->bindInt32(idx + 5, info->m_isDeleted);
+            stmt->bindTime(idx + 6, info->m_createTime);
+            stmt->bindTime(idx + 7, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int CategoryInfoDao::Delete(CategoryInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from category where id = ?";
     auto stmt = conn->prepare(sql);
@@ -192,6 +277,60 @@ int CategoryInfoDao::QueryAll(std::vector<CategoryInfo::ptr>& results, sylar::ID
     return 0;
 }
 
+int CategoryInfoDao::QueryAll(std::function<void(CategoryInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, name, parent_id, is_deleted, create_time, update_time from category";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        CategoryInfo::ptr v(new CategoryInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_name = rt->getString(2);
+        v->m_parentId = rt->getInt64(3);
+        v->m_isDeleted = rt->getInt32(4);
+        v->m_createTime = rt->getTime(5);
+        v->m_updateTime = rt->getTime(6);
+        cb(v);
+    }
+    return 0;
+}
+
+int CategoryInfoDao::QueryByIdRange(std::function<void(CategoryInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, name, parent_id, is_deleted, create_time, update_time from category where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        CategoryInfo::ptr v(new CategoryInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_name = rt->getString(2);
+        v->m_parentId = rt->getInt64(3);
+        v->m_isDeleted = rt->getInt32(4);
+        v->m_createTime = rt->getTime(5);
+        v->m_updateTime = rt->getTime(6);
+        cb(v);
+    }
+    return 0;
+}
+
 CategoryInfo::ptr CategoryInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, user_id, name, parent_id, is_deleted, create_time, update_time from category where id = ?";
     auto stmt = conn->prepare(sql);
@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -58,12 +59,17 @@ public:
     static int Update(CategoryInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(CategoryInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(CategoryInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<CategoryInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(CategoryInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteByUserId( const int64_t& user_id, sylar::IDB::ptr conn);
     static int DeleteByUserIdName( const int64_t& user_id,  const std::string& name, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<CategoryInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(CategoryInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(CategoryInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static CategoryInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryByUserId(std::vector<CategoryInfo::ptr>& results,  const int64_t& user_id, sylar::IDB::ptr conn);
     static CategoryInfo::ptr QueryByUserIdName( const int64_t& user_id,  const std::string& name, sylar::IDB::ptr conn);
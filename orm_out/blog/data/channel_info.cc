@@ -90,6 +90,85 @@ int ChannelInfoDao::InsertOrUpdate(ChannelInfo::ptr info, sylar::IDB::ptr conn)
     return stmt->execute();
 }
 
+int ChannelInfoDao::InsertMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into channel (name, create_time, update_time) values (?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 3;
+            stmt->bindString(idx + 1, info->m_name);
+            stmt->bindTime(idx + 2, info->m_createTime);
+            stmt->bindTime(idx + 3, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ChannelInfoDao::UpdateMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int ChannelInfoDao::UpsertMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into channel (id, name, create_time, update_time) values (?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 4;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindString(idx + 2, info->m_name);
+            stmt->bindTime(idx + 3, info->m_createTime);
+            stmt->bindTime(idx + 4, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int ChannelInfoDao::Delete(ChannelInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from channel where id = ?";
     auto stmt = conn->prepare(sql);
@@ -137,6 +216,54 @@ int ChannelInfoDao::QueryAll(std::vector<ChannelInfo::ptr>& results, sylar::IDB:
     return 0;
 }
 
+int ChannelInfoDao::QueryAll(std::function<void(ChannelInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, name, create_time, update_time from channel";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ChannelInfo::ptr v(new ChannelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_name = rt->getString(1);
+        v->m_createTime = rt->getTime(2);
+        v->m_updateTime = rt->getTime(3);
+        cb(v);
+    }
+    return 0;
+}
+
+int ChannelInfoDao::QueryByIdRange(std::function<void(ChannelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, name, create_time, update_time from channel where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        ChannelInfo::ptr v(new ChannelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_name = rt->getString(1);
+        v->m_createTime = rt->getTime(2);
+        v->m_updateTime = rt->getTime(3);
+        cb(v);
+    }
+    return 0;
+}
+
 ChannelInfo::ptr ChannelInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, name, create_time, update_time from channel where id = ?";
     auto stmt = conn->prepare(sql);
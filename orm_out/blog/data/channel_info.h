@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -46,10 +47,15 @@ public:
     static int Update(ChannelInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(ChannelInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(ChannelInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<ChannelInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(ChannelInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<ChannelInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(ChannelInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(ChannelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static ChannelInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int CreateTableSQLite3(sylar::IDB::ptr info);
     static int CreateTableMySQL(sylar::IDB::ptr info);
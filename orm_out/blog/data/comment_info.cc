@@ -135,6 +135,95 @@ int CommentInfoDao::InsertOrUpdate(CommentInfo::ptr info, sylar::IDB::ptr conn)
     return stmt->execute();
 }
 
+int CommentInfoDao::InsertMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into comment (user_id, article_id, content, parent_id, state, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 8;
+            stmt->bindInt64(idx + 1, info->m_userId);
+            stmt->bindInt64(idx + 2, info->m_articleId);
+            stmt->bindString(idx + 3, info->m_content);
+            stmt->bindInt64(idx + 4, info->m_parentId);
+            stmt->bindInt32(idx + 5, info->m_state);
+            stmt->bindInt32(idx + 6, info->m_isDeleted);
+            stmt->bindTime(idx + 7, info->m_createTime);
+            stmt->bindTime(idx + 8, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int CommentInfoDao::UpdateMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int CommentInfoDao::UpsertMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into comment (id, user_id, article_id, content, parent_id, state, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 9;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindInt64(idx + 2, info->m_userId);
+            stmt->bindInt64(idx + 3, info->m_articleId);
+            stmt->bindString(idx + 4, info->m_content);
+            stmt->bindInt64(idx + 5, info->m_parentId);
+            stmt->bindInt32(idx + 6, info->m_state);
+            stmt->bindInt32(idx + 7, info->m_isDeleted);
+            stmt->bindTime(idx + 8, info->m_createTime);
+            stmt->bindTime(idx + 9, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int CommentInfoDao::Delete(CommentInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from comment where id = ?";
     auto stmt = conn->prepare(sql);
@@ -211,6 +300,64 @@ int CommentInfoDao::QueryAll(std::vector<CommentInfo::ptr>& results, sylar::IDB:
     return 0;
 }
 
+int CommentInfoDao::QueryAll(std::function<void(CommentInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, article_id, content, parent_id, state, is_deleted, create_time, update_time from comment";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        CommentInfo::ptr v(new CommentInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_articleId = rt->getInt64(2);
+        v->m_content = rt->getString(3);
+        v->m_parentId = rt->getInt64(4);
+        v->m_state = rt->getInt32(5);
+        v->m_isDeleted = rt->getInt32(6);
+        v->m_createTime = rt->getTime(7);
+        v->m_updateTime = rt->getTime(8);
+        cb(v);
+    }
+    return 0;
+}
+
+int CommentInfoDao::QueryByIdRange(std::function<void(CommentInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, article_id, content, parent_id, state, is_deleted, create_time, update_time from comment where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        CommentInfo::ptr v(new CommentInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_articleId = rt->getInt64(2);
+        v->m_content = rt->getString(3);
+        v->m_parentId = rt->getInt64(4);
+        v->m_state = rt->getInt32(5);
+        v->m_isDeleted = rt->getInt32(6);
+        v->m_createTime = rt->getTime(7);
+        v->m_updateTime = rt->getTime(8);
+        cb(v);
+    }
+    return 0;
+}
+
 CommentInfo::ptr CommentInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, user_id, article_id, content, parent_id, state, is_deleted, create_time, update_time from comment where id = ?";
     auto stmt = conn->prepare(sql);
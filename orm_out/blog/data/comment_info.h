@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -66,12 +67,17 @@ public:
     static int Update(CommentInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(CommentInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(CommentInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<CommentInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(CommentInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteByUserId( const int64_t& user_id, sylar::IDB::ptr conn);
     static int DeleteByArticleId( const int64_t& article_id, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<CommentInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(CommentInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(CommentInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static CommentInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static int QueryByUserId(std::vector<CommentInfo::ptr>& results,  const int64_t& user_id, sylar::IDB::ptr conn);
     static int QueryByArticleId(std::vector<CommentInfo::ptr>& results,  const int64_t& article_id, sylar::IDB::ptr conn);
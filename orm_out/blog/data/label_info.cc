@@ -108,6 +108,89 @@ int LabelInfoDao::InsertOrUpdate(LabelInfo::ptr info, sylar::IDB::ptr conn) {
     return stmt->execute();
 }
 
+int LabelInfoDao::InsertMany(const std::vector<LabelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into label (user_id, name, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 5;
+            stmt->bindInt64(idx + 1, info->m_userId);
+            stmt->bindString(idx + 2, info->m_name);
+            stmt->bindInt32(idx + 3, info->m_isDeleted);
+            stmt->bindTime(idx + 4, info->m_createTime);
+            stmt->bindTime(idx + 5, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int LabelInfoDao::UpdateMany(const std::vector<LabelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int LabelInfoDao::UpsertMany(const std::vector<LabelInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into label (id, user_id, name, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 6;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindInt64(idx + 2, info->m_userId);
+            stmt->bindString(idx + 3, info->m_name);
+            stmt->bindInt32(idx + 4, info->m_isDeleted);
+            stmt->bindTime(idx + 5, info->m_createTime);
+            stmt->bindTime(idx + 6, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int LabelInfoDao::Delete(LabelInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from label where id = ?";
     auto stmt = conn->prepare(sql);
@@ -182,6 +265,58 @@ int LabelInfoDao::QueryAll(std::vector<LabelInfo::ptr>& results, sylar::IDB::ptr
     return 0;
 }
 
+int LabelInfoDao::QueryAll(std::function<void(LabelInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, name, is_deleted, create_time, update_time from label";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        LabelInfo::ptr v(new LabelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_name = rt->getString(2);
+        v->m_isDeleted = rt->getInt32(3);
+        v->m_createTime = rt->getTime(4);
+        v->m_updateTime = rt->getTime(5);
+        cb(v);
+    }
+    return 0;
+}
+
+int LabelInfoDao::QueryByIdRange(std::function<void(LabelInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, user_id, name, is_deleted, create_time, update_time from label where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        LabelInfo::ptr v(new LabelInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_userId = rt->getInt64(1);
+        v->m_name = rt->getString(2);
+        v->m_isDeleted = rt->getInt32(3);
+        v->m_createTime = rt->getTime(4);
+        v->m_updateTime = rt->getTime(5);
+        cb(v);
+    }
+    return 0;
+}
+
 LabelInfo::ptr LabelInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, user_id, name, is_deleted, create_time, update_time from label where id = ?";
     auto stmt = conn->prepare(sql);
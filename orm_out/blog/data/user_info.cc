@@ -162,6 +162,101 @@ int UserInfoDao::InsertOrUpdate(UserInfo::ptr info, sylar::IDB::ptr conn) {
     return stmt->execute();
 }
 
+int UserInfoDao::InsertMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "insert into user (account, email, passwd, name, code, role, state, login_time, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 11;
+            stmt->bindString(idx + 1, info->m_account);
+            stmt->bindString(idx + 2, info->m_email);
+            stmt->bindString(idx + 3, info->m_passwd);
+            stmt->bindString(idx + 4, info->m_name);
+            stmt->bindString(idx + 5, info->m_code);
+            stmt->bindInt32(idx + 6, info->m_role);
+            stmt->bindInt32(idx + 7, info->m_state);
+            stmt->bindTime(idx + 8, info->m_loginTime);
+            stmt->bindInt32(idx + 9, info->m_isDeleted);
+            stmt->bindTime(idx + 10, info->m_createTime);
+            stmt->bindTime(idx + 11, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int UserInfoDao::UpdateMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    for(auto& i : infos) {
+        int rt = Update(i, conn);
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
+int UserInfoDao::UpsertMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn) {
+    static const size_t s_batch = 64;
+    for(size_t pos = 0; pos < infos.size(); pos += s_batch) {
+        size_t count = infos.size() - pos;
+        if(count > s_batch) {
+            count = s_batch;
+        }
+        std::string sql = "replace into user (id, account, email, passwd, name, code, role, state, login_time, is_deleted, create_time, update_time) values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        for(size_t i = 1; i < count; ++i) {
+            sql += ", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        }
+        auto stmt = conn->prepare(sql);
+        if(!stmt) {
+            SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                     << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+            return conn->getErrno();
+        }
+        for(size_t i = 0; i < count; ++i) {
+            auto& info = infos[pos + i];
+            int idx = i * 12;
+            if(info->m_id) {
+                stmt->bindInt64(idx + 1, info->m_id);
+            } else {
+                stmt->bindNull(idx + 1);
+            }
+            stmt->bindString(idx + 2, info->m_account);
+            stmt->bindString(idx + 3, info->m_email);
+            stmt->bindString(idx + 4, info->m_passwd);
+            stmt->bindString(idx + 5, info->m_name);
+            stmt->bindString(idx + 6, info->m_code);
+            stmt->bindInt32(idx + 7, info->m_role);
+            stmt->bindInt32(idx + 8, info->m_state);
+            stmt->bindTime(idx + 9, info->m_loginTime);
+            stmt->bindInt32(idx + 10, info->m_isDeleted);
+            stmt->bindTime(idx + 11, info->m_createTime);
+            stmt->bindTime(idx + 12, info->m_updateTime);
+        }
+        int rt = stmt->execute();
+        if(rt) {
+            return rt;
+        }
+    }
+    return 0;
+}
+
 int UserInfoDao::Delete(UserInfo::ptr info, sylar::IDB::ptr conn) {
     std::string sql = "delete from user where id = ?";
     auto stmt = conn->prepare(sql);
@@ -253,6 +348,70 @@ int UserInfoDao::QueryAll(std::vector<UserInfo::ptr>& results, sylar::IDB::ptr c
     return 0;
 }
 
+int UserInfoDao::QueryAll(std::function<void(UserInfo::ptr)> cb, sylar::IDB::ptr conn) {
+    std::string sql = "select id, account, email, passwd, name, code, role, state, login_time, is_deleted, create_time, update_time from user";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        UserInfo::ptr v(new UserInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_account = rt->getString(1);
+        v->m_email = rt->getString(2);
+        v->m_passwd = rt->getString(3);
+        v->m_name = rt->getString(4);
+        v->m_code = rt->getString(5);
+        v->m_role = rt->getInt32(6);
+        v->m_state = rt->getInt32(7);
+        v->m_loginTime = rt->getTime(8);
+        v->m_isDeleted = rt->getInt32(9);
+        v->m_createTime = rt->getTime(10);
+        v->m_updateTime = rt->getTime(11);
+        cb(v);
+    }
+    return 0;
+}
+
+int UserInfoDao::QueryByIdRange(std::function<void(UserInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn) {
+    std::string sql = "select id, account, email, passwd, name, code, role, state, login_time, is_deleted, create_time, update_time from user where id >= ? and id < ? order by id";
+    auto stmt = conn->prepare(sql);
+    if(!stmt) {
+        SYLAR_LOG_ERROR(g_logger) << "stmt=" << sql
+                 << " errno=" << conn->getErrno() << " errstr=" << conn->getErrStr();
+        return conn->getErrno();
+    }
+    stmt->bindInt64(1, begin);
+    stmt->bindInt64(2, end);
+    auto rt = stmt->query();
+    if(!rt) {
+        return stmt->getErrno();
+    }
+    while (rt->next()) {
+        UserInfo::ptr v(new UserInfo);
+        v->m_id = rt->getInt64(0);
+        v->m_account = rt->getString(1);
+        v->m_email = rt->getString(2);
+        v->m_passwd = rt->getString(3);
+        v->m_name = rt->getString(4);
+        v->m_code = rt->getString(5);
+        v->m_role = rt->getInt32(6);
+        v->m_state = rt->getInt32(7);
+        v->m_loginTime = rt->getTime(8);
+        v->m_isDeleted = rt->getInt32(9);
+        v->m_createTime = rt->getTime(10);
+        v->m_updateTime = rt->getTime(11);
+        cb(v);
+    }
+    return 0;
+}
+
 UserInfo::ptr UserInfoDao::Query( const int64_t& id, sylar::IDB::ptr conn) {
     std::string sql = "select id, account, email, passwd, name, code, role, state, login_time, is_deleted, create_time, update_time from user where id = ?";
     auto stmt = conn->prepare(sql);
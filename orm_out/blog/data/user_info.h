@@ -3,6 +3,7 @@
 
 #include <json/json.h>
 #include <vector>
+#include <functional>
 #include "sylar/db/db.h"
 #include "sylar/util.h"
 
@@ -78,6 +79,9 @@ public:
     static int Update(UserInfo::ptr info, sylar::IDB::ptr conn);
     static int Insert(UserInfo::ptr info, sylar::IDB::ptr conn);
     static int InsertOrUpdate(UserInfo::ptr info, sylar::IDB::ptr conn);
+    static int InsertMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpdateMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn);
+    static int UpsertMany(const std::vector<UserInfo::ptr>& infos, sylar::IDB::ptr conn);
     static int Delete(UserInfo::ptr info, sylar::IDB::ptr conn);
     static int Delete(const int64_t& id, sylar::IDB::ptr conn);
     static int DeleteById( const int64_t& id, sylar::IDB::ptr conn);
@@ -85,6 +89,8 @@ public:
     static int DeleteByEmail( const std::string& email, sylar::IDB::ptr conn);
     static int DeleteByName( const std::string& name, sylar::IDB::ptr conn);
     static int QueryAll(std::vector<UserInfo::ptr>& results, sylar::IDB::ptr conn);
+    static int QueryAll(std::function<void(UserInfo::ptr)> cb, sylar::IDB::ptr conn);
+    static int QueryByIdRange(std::function<void(UserInfo::ptr)> cb,  const int64_t& begin,  const int64_t& end, sylar::IDB::ptr conn);
     static UserInfo::ptr Query( const int64_t& id, sylar::IDB::ptr conn);
     static UserInfo::ptr QueryByAccount( const std::string& account, sylar::IDB::ptr conn);
     static UserInfo::ptr QueryByEmail( const std::string& email, sylar::IDB::ptr conn);
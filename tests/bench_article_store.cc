@@ -0,0 +1,247 @@
+#include "blog/manager/article_manager.h"
+#include "blog/manager/article_category_rel_manager.h"
+#include "blog/manager/article_label_rel_manager.h"
+#include "blog/manager/category_manager.h"
+#include "blog/manager/channel_manager.h"
+#include "blog/manager/label_manager.h"
+#include "blog/manager/user_manager.h"
+
+#include "sylar/thread.h"
+#include "sylar/util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <dlfcn.h>
+#include <iostream>
+#include <pthread.h>
+
+//统计本线程的加锁次数: 可执行文件中定义的同名函数优先于libpthread, 计数后转发
+static thread_local uint64_t s_locks = 0;
+
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t* m) {
+    static auto real = (int(*)(pthread_mutex_t*))dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    ++s_locks;
+    return real(m);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* l) {
+    static auto real = (int(*)(pthread_rwlock_t*))dlsym(RTLD_NEXT, "pthread_rwlock_rdlock");
+    ++s_locks;
+    return real(l);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* l) {
+    static auto real = (int(*)(pthread_rwlock_t*))dlsym(RTLD_NEXT, "pthread_rwlock_wrlock");
+    ++s_locks;
+    return real(l);
+}
+
+}
+
+//与/article/snappy的渲染回调相同的字段
+static bool render(int64_t id, Json::Value& v) {
+    blog::ArticleView info;
+    if(!blog::ArticleMgr::GetInstance()->view(id, info)) {
+        return false;
+    }
+    v["id"] = info.id;
+    v["title"] = info.title;
+    v["content"] = info.summary;
+    v["user_id"] = info.userId;
+    auto cats = blog::ArticleCategoryRelMgr::GetInstance()->getIndex()->listByArticleId(id);
+    if(cats) {
+        for(auto& i : *cats) {
+            v["categorys"].append(i.name);
+        }
+    }
+    auto labels = blog::ArticleLabelRelMgr::GetInstance()->getIndex()->listByArticleId(id);
+    if(labels) {
+        for(auto& i : *labels) {
+            v["labels"].append(i.name);
+        }
+    }
+    return true;
+}
+
+static size_t emit(int64_t id, const blog::ArticleView& info
+                   ,blog::data::UserInfo::ptr user, blog::data::ChannelInfo::ptr channel) {
+    blog::ArticleRenderCache::Fragment::ptr frag;
+    if(!blog::ArticleMgr::GetInstance()->render(blog::ArticleRenderCache::SNAPPY, id
+                ,std::bind(render, id, std::placeholders::_1), frag)) {
+        return 0;
+    }
+    return frag->json.size() + (user ? user->getName().size() : 0)
+        + (channel ? channel->getName().size() : 0) + info.views;
+}
+
+//逐个id读取各管理器(批量接口之前的/article/snappy)
+static size_t per_id(const std::vector<int64_t>& ids) {
+    size_t n = 0;
+    for(auto& id : ids) {
+        blog::ArticleView info;
+        if(!blog::ArticleMgr::GetInstance()->view(id, info)) {
+            continue;
+        }
+        auto user = blog::UserMgr::GetInstance()->get(info.userId);
+        auto channel = blog::ChannelMgr::GetInstance()->get(info.channel);
+        n += emit(id, info, user, channel);
+    }
+    return n;
+}
+
+//每个管理器一次批量读取(当前的/article/snappy)
+static size_t batched(const std::vector<int64_t>& ids) {
+    std::vector<blog::ArticleView> infos;
+    blog::ArticleMgr::GetInstance()->viewMany(ids, infos, false);
+    std::vector<int64_t> uids(infos.size());
+    std::vector<int64_t> chids(infos.size());
+    for(size_t i = 0; i < infos.size(); ++i) {
+        uids[i] = infos[i].userId;
+        chids[i] = infos[i].channel;
+    }
+    std::vector<blog::data::UserInfo::ptr> uinfos;
+    blog::UserMgr::GetInstance()->getMany(uids, uinfos);
+    std::vector<blog::data::ChannelInfo::ptr> cinfos;
+    blog::ChannelMgr::GetInstance()->getMany(chids, cinfos);
+    blog::ArticleCategoryRelMgr::GetInstance()->getIndex();
+    blog::ArticleLabelRelMgr::GetInstance()->getIndex();
+
+    size_t n = 0;
+    for(size_t i = 0; i < infos.size(); ++i) {
+        if(infos[i].id) {
+            n += emit(infos[i].id, infos[i], uinfos[i], cinfos[i]);
+        }
+    }
+    return n;
+}
+
+static void fill(int64_t articles) {
+    for(int64_t i = 1; i <= 1000; ++i) {
+        blog::data::UserInfo::ptr info(new blog::data::UserInfo);
+        info->setId(i);
+        info->setAccount("account_" + std::to_string(i));
+        info->setEmail("user_" + std::to_string(i) + "@bench");
+        info->setName("user_" + std::to_string(i));
+        blog::UserMgr::GetInstance()->add(info);
+    }
+    for(int64_t i = 1; i <= 10; ++i) {
+        blog::data::ChannelInfo::ptr info(new blog::data::ChannelInfo);
+        info->setId(i);
+        info->setName("channel_" + std::to_string(i));
+        blog::ChannelMgr::GetInstance()->add(info);
+    }
+    for(int64_t i = 1; i <= 50; ++i) {
+        blog::data::CategoryInfo::ptr info(new blog::data::CategoryInfo);
+        info->setId(i);
+        info->setUserId(i % 1000 + 1);
+        info->setName("category_" + std::to_string(i));
+        blog::CategoryMgr::GetInstance()->add(info);
+    }
+    for(int64_t i = 1; i <= 100; ++i) {
+        blog::data::LabelInfo::ptr info(new blog::data::LabelInfo);
+        info->setId(i);
+        info->setUserId(i % 1000 + 1);
+        info->setName("label_" + std::to_string(i));
+        blog::LabelMgr::GetInstance()->add(info);
+    }
+    int64_t rel = 0;
+    for(int64_t i = 1; i <= articles; ++i) {
+        blog::data::ArticleInfo::ptr info(new blog::data::ArticleInfo);
+        info->setId(i);
+        info->setUserId(i % 1000 + 1);
+        info->setChannel(i % 10 + 1);
+        info->setTitle("title_" + std::to_string(i));
+        info->setContent(std::string(200, 'a'));
+        info->setUpdateTime(i);
+        blog::ArticleMgr::GetInstance()->add(info);
+        for(int64_t c = 0; c < 2; ++c) {
+            blog::data::ArticleCategoryRelInfo::ptr r(new blog::data::ArticleCategoryRelInfo);
+            r->setId(++rel);
+            r->setArticleId(i);
+            r->setCategoryId((i + c) % 50 + 1);
+            blog::ArticleCategoryRelMgr::GetInstance()->add(r);
+        }
+        for(int64_t l = 0; l < 3; ++l) {
+            blog::data::ArticleLabelRelInfo::ptr r(new blog::data::ArticleLabelRelInfo);
+            r->setId(++rel);
+            r->setArticleId(i);
+            r->setLabelId((i + l) % 100 + 1);
+            blog::ArticleLabelRelMgr::GetInstance()->add(r);
+        }
+    }
+    blog::ArticleCategoryRelMgr::GetInstance()->getIndex();
+    blog::ArticleLabelRelMgr::GetInstance()->getIndex();
+}
+
+//对比/article/snappy逐个id与批量读取各管理器的单请求延迟和加锁次数
+//包括文章/用户/频道/分类标签关系索引和渲染片段缓存, 多线程下体现锁竞争
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? sylar::TypeUtil::Atoi(argv[1]) : 4;
+    int64_t loops = argc > 2 ? sylar::TypeUtil::Atoi(argv[2]) : 20000;
+    int64_t batch = argc > 3 ? sylar::TypeUtil::Atoi(argv[3]) : 50;
+    int64_t articles = argc > 4 ? sylar::TypeUtil::Atoi(argv[4]) : 10000;
+    if(threads <= 0) {
+        threads = 1;
+    }
+    if(loops <= 0 || batch <= 0 || articles <= 0) {
+        std::cout << "Use as[" << argv[0] << " [threads] [loops] [batch] [articles]" << std::endl;
+        return 0;
+    }
+    fill(articles);
+
+    auto run = [&](const char* name, size_t(*request)(const std::vector<int64_t>&)) {
+        std::vector<sylar::Thread::ptr> thrs;
+        std::vector<std::vector<uint64_t> > lats(threads);
+        std::atomic<uint64_t> locks(0);
+        uint64_t start = sylar::GetCurrentUS();
+        for(int i = 0; i < threads; ++i) {
+            thrs.push_back(std::make_shared<sylar::Thread>([&, i]() {
+                std::vector<int64_t> ids(batch);
+                auto& lat = lats[i];
+                lat.reserve(loops);
+                uint64_t n = 0;
+                for(int64_t l = 0; l < loops; ++l) {
+                    for(int64_t b = 0; b < batch; ++b) {
+                        ids[b] = (l * batch + b + i * 7919) % articles + 1;
+                    }
+                    uint64_t begin = s_locks;
+                    uint64_t ts = sylar::GetCurrentUS();
+                    request(ids);
+                    lat.push_back(sylar::GetCurrentUS() - ts);
+                    n += s_locks - begin;
+                }
+                locks += n;
+            }, std::string(name) + "_" + std::to_string(i)));
+        }
+        for(auto& i : thrs) {
+            i->join();
+        }
+        uint64_t used = sylar::GetCurrentUS() - start;
+        std::vector<uint64_t> all;
+        for(auto& i : lats) {
+            all.insert(all.end(), i.begin(), i.end());
+        }
+        std::sort(all.begin(), all.end());
+        uint64_t requests = all.size();
+        std::cout << name << ": threads=" << threads << " loops=" << loops
+                  << " batch=" << batch << " used=" << used << "us"
+                  << " avg=" << (double)used * threads / requests << "us"
+                  << " p50=" << all[requests / 2] << "us"
+                  << " p99=" << all[requests * 99 / 100] << "us"
+                  << " locks_per_request=" << (double)locks / requests
+                  << std::endl;
+    };
+    //先填充渲染片段缓存, 之后测的是稳定状态
+    for(int64_t i = 1; i <= articles; i += batch) {
+        std::vector<int64_t> ids;
+        for(int64_t b = i; b < i + batch && b <= articles; ++b) {
+            ids.push_back(b);
+        }
+        batched(ids);
+    }
+    run("per_id", per_id);
+    run("batched", batched);
+    return 0;
+}
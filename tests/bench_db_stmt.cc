@@ -0,0 +1,76 @@
+#include "blog/db_pool.h"
+#include "blog/util.h"
+#include "blog/data/article_info.h"
+
+#include "sylar/config.h"
+#include "sylar/util.h"
+
+#include <functional>
+#include <iostream>
+
+//对比DAO Update循环在不缓存语句(原始连接, 每次prepare)和连接池缓存语句下的耗时
+//db按conf目录中的db.type/sqlite3.dbs/mysql.dbs配置, 会向article表插入数据, 请使用测试库
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        std::cout << "Use as[" << argv[0] << " conf_dir db_name [loops] [rows]" << std::endl;
+        std::cout << "  db_name: sqlite3.dbs或mysql.dbs中的库名, 须为测试库" << std::endl;
+        return 0;
+    }
+    sylar::Config::LoadFromConfDir(argv[1]);
+    std::string name = argv[2];
+    int64_t loops = argc > 3 ? sylar::TypeUtil::Atoi(argv[3]) : 10000;
+    int64_t rows = argc > 4 ? sylar::TypeUtil::Atoi(argv[4]) : 100;
+    if(loops <= 0 || rows <= 0) {
+        return 0;
+    }
+
+    auto raw = blog::GetRawDB(name);
+    if(!raw) {
+        std::cout << "open db " << name << " fail" << std::endl;
+        return 0;
+    }
+    //表已存在时建表失败, 忽略
+    if(blog::data::ArticleInfoDao::CreateTableSQLite3(raw)) {
+        blog::data::ArticleInfoDao::CreateTableMySQL(raw);
+    }
+
+    std::vector<blog::data::ArticleInfo::ptr> infos;
+    for(int64_t i = 0; i < rows; ++i) {
+        blog::data::ArticleInfo::ptr info(new blog::data::ArticleInfo);
+        info->setUserId(1);
+        info->setTitle("bench_" + std::to_string(i));
+        info->setContent(std::string(200, 'a'));
+        info->setCreateTime(time(0));
+        info->setUpdateTime(time(0));
+        if(blog::data::ArticleInfoDao::Insert(info, raw)) {
+            std::cout << "insert fail " << raw->getErrStr() << std::endl;
+            return 0;
+        }
+        infos.push_back(info);
+    }
+
+    auto run = [&](const char* tag, std::function<sylar::IDB::ptr()> get) {
+        int64_t fails = 0;
+        uint64_t start = sylar::GetCurrentUS();
+        for(int64_t l = 0; l < loops; ++l) {
+            auto& info = infos[l % infos.size()];
+            info->setViews(l);
+            if(blog::data::ArticleInfoDao::Update(info, get())) {
+                ++fails;
+            }
+        }
+        uint64_t used = sylar::GetCurrentUS() - start;
+        std::cout << tag << ": loops=" << loops << " used=" << used << "us"
+                  << " per_update=" << (double)used / loops << "us"
+                  << " fails=" << fails << std::endl;
+    };
+
+    //原始连接上每次Update都重新prepare
+    run("uncached", [raw]() { return raw; });
+
+    //与GetDB()相同, 每次借出连接, 语句按sql缓存在连接上
+    blog::DBPool pool(name);
+    run("pooled", [&pool]() { return pool.get(); });
+    std::cout << pool.statusString();
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "blog/json_writer.h"
+
+#include "sylar/util.h"
+
+#include <iostream>
+
+//对比jsoncpp构建DOM再序列化与JsonWriter直接输出, 数据形如/article/snappy的响应
+static void fill_dom(Json::Value& v, int64_t items) {
+    v["code"] = 200;
+    v["msg"] = "ok";
+    Json::Value& data = v["data"];
+    for(int64_t i = 0; i < items; ++i) {
+        Json::Value item;
+        item["id"] = std::to_string(i + 1);
+        item["user_id"] = std::to_string(i % 100 + 1);
+        item["user_name"] = "user_" + std::to_string(i % 100);
+        item["title"] = "title \"" + std::to_string(i) + "\" 标题";
+        item["summary"] = std::string(100, 's');
+        item["views"] = (Json::Int64)(i * 13);
+        item["praise"] = (Json::Int64)(i * 3);
+        item["publish_time"] = "2020-01-01 00:00:00";
+        data.append(item);
+    }
+}
+
+static void fill_writer(blog::JsonWriter& w, int64_t items) {
+    w.startObject();
+    w.set("code", 200);
+    w.set("msg", "ok");
+    w.key("data");
+    w.startArray();
+    for(int64_t i = 0; i < items; ++i) {
+        w.startObject();
+        w.set("id", std::to_string(i + 1));
+        w.set("user_id", std::to_string(i % 100 + 1));
+        w.set("user_name", "user_" + std::to_string(i % 100));
+        w.set("title", "title \"" + std::to_string(i) + "\" 标题");
+        w.set("summary", std::string(100, 's'));
+        w.set("views", (int64_t)(i * 13));
+        w.set("praise", (int64_t)(i * 3));
+        w.set("publish_time", "2020-01-01 00:00:00");
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+}
+
+int main(int argc, char** argv) {
+    int64_t loops = argc > 1 ? sylar::TypeUtil::Atoi(argv[1]) : 20000;
+    int64_t items = argc > 2 ? sylar::TypeUtil::Atoi(argv[2]) : 50;
+    if(loops <= 0 || items < 0) {
+        std::cout << "Use as[" << argv[0] << " [loops] [items]" << std::endl;
+        return 0;
+    }
+
+    size_t bytes = 0;
+    uint64_t start = sylar::GetCurrentUS();
+    for(int64_t l = 0; l < loops; ++l) {
+        Json::Value v;
+        fill_dom(v, items);
+        Json::FastWriter fw;
+        bytes += fw.write(v).size();
+    }
+    uint64_t used = sylar::GetCurrentUS() - start;
+    std::cout << "jsoncpp: loops=" << loops << " items=" << items
+              << " used=" << used << "us per_request=" << (double)used / loops
+              << "us bytes=" << bytes << std::endl;
+
+    bytes = 0;
+    start = sylar::GetCurrentUS();
+    for(int64_t l = 0; l < loops; ++l) {
+        std::string& buf = blog::JsonWriter::Buffer();
+        blog::JsonWriter w(buf);
+        fill_writer(w, items);
+        bytes += buf.size();
+    }
+    used = sylar::GetCurrentUS() - start;
+    std::cout << "JsonWriter: loops=" << loops << " items=" << items
+              << " used=" << used << "us per_request=" << (double)used / loops
+              << "us bytes=" << bytes << std::endl;
+    return 0;
+}
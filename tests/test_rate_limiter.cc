@@ -0,0 +1,42 @@
+#include "blog/rate_limiter.h"
+
+#include "sylar/config.h"
+
+#include <iostream>
+
+//已登录用户从多个ip刷/comment/create, 按uid的桶也要限住
+int main(int argc, char** argv) {
+    blog::RateLimiter::RuleMap rules;
+    rules["/comment/create"]["ip_rate"] = 10;
+    rules["/comment/create"]["user_rate"] = 5;
+    sylar::Config::Lookup<blog::RateLimiter::RuleMap>("rate_limit.rules")->setValue(rules);
+
+    auto limiter = blog::RateLimiterMgr::GetInstance();
+    int passed = 0;
+    uint32_t retry_after = 0;
+    for(int i = 0; i < 20; ++i) {
+        std::string ip = "10.0.0." + std::to_string(i + 1);
+        if(limiter->check("/comment/create", ip, 42, retry_after)) {
+            ++passed;
+        }
+    }
+    std::cout << "logined flood: passed=" << passed << " retry_after=" << retry_after << std::endl;
+    if(passed != 5 || !retry_after) {
+        std::cout << "FAIL: expect 5 passed by user_rate" << std::endl;
+        return 1;
+    }
+
+    passed = 0;
+    for(int i = 0; i < 20; ++i) {
+        if(limiter->check("/comment/create", "10.0.1.1", 0, retry_after)) {
+            ++passed;
+        }
+    }
+    std::cout << "anonymous flood: passed=" << passed << std::endl;
+    if(passed != 10) {
+        std::cout << "FAIL: expect 10 passed by ip_rate" << std::endl;
+        return 1;
+    }
+    std::cout << "OK" << std::endl;
+    return 0;
+}